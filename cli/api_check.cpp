@@ -0,0 +1,95 @@
+// Checks the C++ interface of src/ripserr.h against known barcodes
+// (`make check`).
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ripserr.h"
+
+// in api_check_unit.cpp
+bool check_second_unit();
+
+static int failures = 0;
+
+static void expect(bool ok, const char* what) {
+	if (!ok) {
+		std::fprintf(stderr, "failed: %s\n", what);
+		++failures;
+	}
+}
+
+int main() {
+	ripserr::barcode result;
+	std::string message;
+
+	// the corners of the unit square: 3 finite components and 1 loop
+	const std::vector<float> square = {1, 1.41421356f, 1, 1, 1.41421356f, 1};
+	expect(ripserr::vietoris_rips(square, ripserr::vr_options(), result, &message) == ripserr::OK,
+	       "square");
+	expect(result.size() == 5 && result.dimension[4] == 1 && result.birth[4] == 1 &&
+	           std::abs(result.death[4] - std::sqrt(2.0)) < 1e-6 && std::isinf(result.death[3]),
+	       "square barcode");
+
+	// no pairs of dimensions below `min_dim`, also in degree 0 alone
+	ripserr::vr_options above;
+	above.max_dim = 0;
+	above.min_dim = 1;
+	result.clear();
+	expect(ripserr::vietoris_rips(square, above, result, &message) == ripserr::OK && result.size() == 0,
+	       "square above max_dim");
+
+	// the same square from its points, in degree 0
+	const std::vector<double> corners = {0, 1, 1, 0, 0, 0, 1, 1};
+	result.clear();
+	expect(ripserr::vietoris_rips_0(corners, 2, ripserr::vr_options(), result, &message) == ripserr::OK &&
+	           result.size() == 4 && result.death[0] == 1 && std::isinf(result.death[3]),
+	       "square points");
+
+	// a ring of 1s around a 0, in both filtrations
+	const std::vector<double> ring = {0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 1, 0,
+	                                  1, 0, 0, 1, 1, 1, 0, 0, 0, 0, 0, 0};
+	const std::vector<int> extents = {5, 5};
+	ripserr::cubical_options options;
+	result.clear();
+	expect(ripserr::cubical(ring, extents, options, result, &message) == ripserr::OK &&
+	           result.size() == 2 && result.dimension[0] == 0 && result.death[0] == 1,
+	       "ring");
+	options.sublevel = false;
+	result.clear();
+	expect(ripserr::cubical(ring, extents, options, result, &message) == ripserr::OK &&
+	           result.size() == 1 && result.dimension[0] == 1 && result.birth[0] == 1 &&
+	           result.death[0] == 0,
+	       "ring (superlevel)");
+
+	// the windows of 4 corners of the square among 6 points: a loop, and not
+	std::vector<ripserr::barcode> windows;
+	const std::vector<double> stream = {0, 1, 1, 0, 0, 5, 0, 0, 1, 1, 0, 5};
+	ripserr::vr_options windows_options;
+	windows_options.threads = 2;
+	expect(ripserr::vietoris_rips_windows(stream, 2, 4, 2, windows_options, windows, &message) ==
+	               ripserr::OK &&
+	           windows.size() == 2 && windows[0].size() == 5 && windows[0].dimension[4] == 1 &&
+	           windows[1].size() == 4,
+	       "sliding windows");
+
+	// invalid input is reported, not thrown
+	const std::vector<float> ragged = {1, 2};
+	expect(ripserr::vietoris_rips(ragged, ripserr::vr_options(), result, &message) ==
+	               ripserr::INVALID_ARGUMENT &&
+	           !message.empty(),
+	       "ragged distances");
+
+	ripserr::vr_options tight;
+	tight.max_memory = 1;
+	expect(ripserr::vietoris_rips(square, tight, result, &message) == ripserr::ENGINE_ERROR &&
+	           message.find("max_memory") != std::string::npos,
+	       "memory budget");
+	const std::vector<int> wrong_extents = {5, 4};
+	expect(ripserr::cubical(ring, wrong_extents, options, result, &message) == ripserr::INVALID_ARGUMENT,
+	       "wrong extents");
+
+	expect(check_second_unit(), "second translation unit");
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+// A second translation unit of api_check, so that `make check` links the
+// headers of src/ripserr.h twice and fails on definitions that are not inline.
+
+#include "ripserr.h"
+
+// the two points of a unit segment merge at 1
+bool check_second_unit() {
+	const std::vector<double> segment = {0, 1};
+	ripserr::barcode result;
+	return ripserr::vietoris_rips_0(segment, 1, ripserr::vr_options(), result) == ripserr::OK &&
+	       result.size() == 2 && result.death[0] == 1;
+}
@@ -0,0 +1,327 @@
+// Microbenchmarks of the hot kernels of the engines, without R (`make bench`).
+//
+// Each benchmark runs a fixed, seeded workload of one kernel repeatedly for at
+// least `--min-time` seconds (0.25 by default) and reports the best time per
+// operation over its runs, along with a checksum of the results that must not
+// change when a kernel is merely made faster. A pattern as the first argument
+// restricts the benchmarks to those whose names contain it.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "ripser.h"
+#include "cubical_2dim.h"
+#include "cubical_3dim.h"
+#include "cubical_4dim.h"
+
+namespace {
+
+// The uniform doubles in [0, 1) of a fixed seed, identical on all platforms
+// (unlike the distributions of the standard library).
+class uniform {
+	std::mt19937_64 engine;
+
+public:
+	explicit uniform(uint64_t seed) : engine(seed) {}
+
+	double operator()() { return (engine() >> 11) * 0x1.0p-53; }
+	int64_t below(int64_t n) { return int64_t(engine() % uint64_t(n)); }
+};
+
+// A kernel run over its workload, returning the number of operations and
+// adding to the checksum.
+struct benchmark {
+	const char* name;
+	const char* operation;
+	std::function<uint64_t(uint64_t&)> run;
+};
+
+// The distances between `n` uniform points of the unit cube.
+vr::compressed_lower_distance_matrix random_distances(vr::index_t n, uint64_t seed) {
+	uniform u(seed);
+	std::vector<double> points(3 * n);
+	for (double& x : points) x = u();
+	std::vector<vr::value_t> distances;
+	distances.reserve(n * (n - 1) / 2);
+	for (vr::index_t i = 1; i < n; ++i)
+		for (vr::index_t j = 0; j < i; ++j) {
+			double d = 0;
+			for (int k = 0; k < 3; ++k) d += (points[3 * i + k] - points[3 * j + k]) * (points[3 * i + k] - points[3 * j + k]);
+			distances.push_back(vr::value_t(std::sqrt(d)));
+		}
+	return vr::compressed_lower_distance_matrix(std::move(distances));
+}
+
+typedef vr::diameter_entry<vr::index_t> diameter_entry_t;
+typedef vr::ripser<vr::compressed_lower_distance_matrix> dense_ripser;
+typedef vr::ripser<vr::sparse_distance_matrix> sparse_ripser;
+
+// `count` random simplices of dimension `dim` (with their diameters) on `n`
+// vertices.
+template <typename Ripser>
+std::vector<diameter_entry_t> random_simplices(const Ripser& ripser, vr::index_t n, vr::index_t dim,
+                                               size_t count, uint64_t seed) {
+	uniform u(seed);
+	const vr::binomial_coeff_table<vr::index_t> binomial_coeff(n, dim + 2);
+	std::vector<diameter_entry_t> simplices;
+	std::vector<vr::index_t> vertices;
+	while (simplices.size() < count) {
+		vertices.clear();
+		while (vertices.size() < size_t(dim + 1)) {
+			vr::index_t v = u.below(n);
+			if (std::find(vertices.begin(), vertices.end(), v) == vertices.end()) vertices.push_back(v);
+		}
+		std::sort(vertices.begin(), vertices.end());
+		vr::index_t index = 0;
+		for (vr::index_t k = 0; k <= dim; ++k) index += binomial_coeff(vertices[k], k + 1);
+		simplices.emplace_back(ripser.compute_diameter(index, dim), index, 1);
+	}
+	return simplices;
+}
+
+const vr::index_t num_points = 400;
+
+// the dense and sparse engines over the same points, built once
+dense_ripser& dense_engine() {
+	static dense_ripser* engine = new dense_ripser(random_distances(num_points, 1), 2,
+	                                               std::numeric_limits<vr::value_t>::max(), 1, 2);
+	return *engine;
+}
+
+sparse_ripser& sparse_engine() {
+	static sparse_ripser* engine = new sparse_ripser(
+	    vr::sparse_distance_matrix(random_distances(num_points, 1), vr::value_t(0.3)), 2, vr::value_t(0.3), 1, 2);
+	return *engine;
+}
+
+// The columns of dimensions 0 and 1 of a random image, as the engines see
+// them, and the grid they index.
+template <typename Grid, typename Columns, typename Enumerator, typename Index>
+struct cubical_workload {
+	std::vector<double> values;
+	std::unique_ptr<Grid> grid;
+	std::vector<Index> columns;
+
+	template <typename... Extents> cubical_workload(uint64_t seed, Extents... extents) {
+		uniform u(seed);
+		values.resize(size_t(1) * (... * extents));
+		for (double& x : values) x = u();
+		grid.reset(new Grid(voxel_buffer(values.data()), 9999, extents...));
+		Columns ctr(grid.get());
+		columns = ctr.columns_to_reduce;
+		// the edges are the cofaces of the vertices
+		const size_t num_vertices = columns.size();
+		Enumerator cofaces;
+		for (size_t i = 0; i < num_vertices; ++i) {
+			cofaces.set(columns[i], grid.get());
+			while (cofaces.hasNextCoface()) {
+				Index coface = cofaces.getNextCoface();
+				// each edge is the coface of two vertices; keep it once
+				if (coface.birthday == columns[i].birthday) columns.push_back(coface);
+			}
+		}
+	}
+
+	uint64_t run(uint64_t& checksum) {
+		Enumerator cofaces;
+		uint64_t ops = 0;
+		for (const Index& column : columns) {
+			cofaces.set(column, grid.get());
+			while (cofaces.hasNextCoface()) {
+				checksum += uint64_t(cofaces.getNextCoface().index);
+				++ops;
+			}
+		}
+		return ops;
+	}
+};
+
+struct enumerator2 : cubical2::SimplexCoboundaryEnumerator2 {
+	void set(cubical2::BirthdayIndex2 s, cubical2::DenseCubicalGrids2* grid) { setSimplexCoboundaryEnumerator2(s, grid); }
+};
+struct enumerator3 : cubical3::SimplexCoboundaryEnumerator3 {
+	void set(cubical3::BirthdayIndex3 s, cubical3::DenseCubicalGrids3* grid) { setSimplexCoboundaryEnumerator3(s, grid); }
+};
+struct enumerator4 : cubical4::SimplexCoboundaryEnumerator4 {
+	void set(cubical4::BirthdayIndex4 s, cubical4::DenseCubicalGrids4* grid) { setSimplexCoboundaryEnumerator4(s, grid); }
+};
+
+typedef cubical_workload<cubical2::DenseCubicalGrids2, cubical2::ColumnsToReduce2, enumerator2, cubical2::BirthdayIndex2>
+    cubical2_workload;
+typedef cubical_workload<cubical3::DenseCubicalGrids3, cubical3::ColumnsToReduce3, enumerator3, cubical3::BirthdayIndex3>
+    cubical3_workload;
+typedef cubical_workload<cubical4::DenseCubicalGrids4, cubical4::ColumnsToReduce4, enumerator4, cubical4::BirthdayIndex4>
+    cubical4_workload;
+
+std::vector<benchmark> benchmarks() {
+	std::vector<benchmark> all;
+
+	all.push_back({"binomial_coeff_table/decode_dim2", "simplex", [](uint64_t& checksum) {
+		               static const std::vector<diameter_entry_t> simplices =
+		                   random_simplices(dense_engine(), num_points, 2, 100000, 2);
+		               std::vector<vr::index_t> vertices(3);
+		               for (const diameter_entry_t& s : simplices) {
+			               dense_engine().get_simplex_vertices(vr::get_index(s), 2, num_points, vertices.rbegin());
+			               checksum += uint64_t(vertices[0] + vertices[1] + vertices[2]);
+		               }
+		               return uint64_t(simplices.size());
+	               }});
+
+	all.push_back({"simplex_coboundary_enumerator/dense_dim1", "cofacet", [](uint64_t& checksum) {
+		               static const std::vector<diameter_entry_t> edges =
+		                   random_simplices(dense_engine(), num_points, 1, 2000, 3);
+		               vr::simplex_coboundary_enumerator<vr::compressed_lower_distance_matrix, vr::index_t> cofacets(
+		                   dense_engine());
+		               uint64_t ops = 0;
+		               for (const diameter_entry_t& e : edges) {
+			               cofacets.set_simplex(e, 1);
+			               while (cofacets.has_next()) {
+				               checksum += uint64_t(vr::get_index(cofacets.next()));
+				               ++ops;
+			               }
+		               }
+		               return ops;
+	               }});
+
+	all.push_back({"simplex_coboundary_enumerator/sparse_dim1", "cofacet", [](uint64_t& checksum) {
+		               // the edges of the sparse matrix below its threshold
+		               static const std::vector<diameter_entry_t> edges = [] {
+			               std::vector<diameter_entry_t> edges;
+			               for (const diameter_entry_t& e : random_simplices(sparse_engine(), num_points, 1, 20000, 4))
+				               if (vr::get_diameter(e) <= vr::value_t(0.3)) edges.push_back(e);
+			               return edges;
+		               }();
+		               vr::simplex_coboundary_enumerator<vr::sparse_distance_matrix, vr::index_t> cofacets(sparse_engine());
+		               uint64_t ops = 0;
+		               for (const diameter_entry_t& e : edges) {
+			               cofacets.set_simplex(e, 1);
+			               while (cofacets.has_next()) {
+				               checksum += uint64_t(vr::get_index(cofacets.next()));
+				               ++ops;
+			               }
+		               }
+		               return ops;
+	               }});
+
+	all.push_back({"simplex_boundary_enumerator/dim2", "facet", [](uint64_t& checksum) {
+		               static const std::vector<diameter_entry_t> triangles =
+		                   random_simplices(dense_engine(), num_points, 2, 100000, 5);
+		               dense_ripser::simplex_boundary_enumerator facets(0, dense_engine());
+		               uint64_t ops = 0;
+		               for (const diameter_entry_t& t : triangles) {
+			               facets.set_simplex(t, 2);
+			               while (facets.has_next()) {
+				               checksum += uint64_t(vr::get_index(facets.next()));
+				               ++ops;
+			               }
+		               }
+		               return ops;
+	               }});
+
+	all.push_back({"pop_pivot/heap", "entry", [](uint64_t& checksum) {
+		               // a column of cofacets, pushed and then popped pivot by pivot, in which
+		               // about half the entries cancel in pairs
+		               static const std::vector<diameter_entry_t> entries = [] {
+			               uniform u(6);
+			               std::vector<diameter_entry_t> entries;
+			               for (int i = 0; i < 100000; ++i) {
+				               const vr::index_t index = u.below(60000);
+				               entries.emplace_back(vr::value_t(index % 997) / 997, index, 1);
+			               }
+			               return entries;
+		               }();
+		               std::priority_queue<diameter_entry_t, std::vector<diameter_entry_t>,
+		                                   vr::greater_diameter_or_smaller_index_comp<diameter_entry_t>>
+		                   column;
+		               for (const diameter_entry_t& e : entries) column.push(e);
+		               for (diameter_entry_t pivot = dense_engine().pop_pivot(column); vr::get_index(pivot) != -1;
+		                    pivot = dense_engine().pop_pivot(column))
+			               checksum += uint64_t(vr::get_index(pivot));
+		               return uint64_t(entries.size());
+	               }});
+
+	all.push_back({"union_find/link_find", "edge", [](uint64_t& checksum) {
+		               const vr::index_t n = 100000;
+		               static const std::vector<std::pair<vr::index_t, vr::index_t>> edges = [n] {
+			               uniform u(7);
+			               std::vector<std::pair<vr::index_t, vr::index_t>> edges(4 * n);
+			               for (auto& e : edges) e = {u.below(n), u.below(n)};
+			               return edges;
+		               }();
+		               vr::union_find dset(n);
+		               for (const auto& e : edges) {
+			               const vr::index_t u = dset.find(e.first), v = dset.find(e.second);
+			               if (u != v) {
+				               dset.link(u, v);
+				               ++checksum;
+			               }
+		               }
+		               return uint64_t(edges.size());
+	               }});
+
+	all.push_back({"SimplexCoboundaryEnumerator2/hasNextCoface", "coface", [](uint64_t& checksum) {
+		               static cubical2_workload* workload = new cubical2_workload(8, 512, 512);
+		               return workload->run(checksum);
+	               }});
+
+	all.push_back({"SimplexCoboundaryEnumerator3/hasNextCoface", "coface", [](uint64_t& checksum) {
+		               static cubical3_workload* workload = new cubical3_workload(9, 64, 64, 64);
+		               return workload->run(checksum);
+	               }});
+
+	all.push_back({"SimplexCoboundaryEnumerator4/hasNextCoface", "coface", [](uint64_t& checksum) {
+		               static cubical4_workload* workload = new cubical4_workload(10, 16, 16, 16, 16);
+		               return workload->run(checksum);
+	               }});
+
+	return all;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const char* pattern = "";
+	double min_time = 0.25;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+			min_time = std::atof(argv[++i]);
+		else
+			pattern = argv[i];
+	}
+
+	std::printf("%-46s %12s %10s  %s\n", "benchmark", "ns/op", "ops/run", "checksum");
+	for (const benchmark& b : benchmarks()) {
+		if (!std::strstr(b.name, pattern)) continue;
+		// a first run to build the workload and warm the caches
+		uint64_t checksum = 0;
+		const uint64_t ops = b.run(checksum);
+		const uint64_t first_checksum = checksum;
+		double best = std::numeric_limits<double>::infinity(), total = 0;
+		do {
+			checksum = 0;
+			const auto start = std::chrono::steady_clock::now();
+			b.run(checksum);
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (checksum != first_checksum) {
+				std::fprintf(stderr, "%s: the checksum changed between runs\n", b.name);
+				return 1;
+			}
+			best = std::min(best, seconds);
+			total += seconds;
+		} while (total < min_time);
+		std::printf("%-46s %12.2f %10llu  %016llx (per %s)\n", b.name, 1e9 * best / ops,
+		            (unsigned long long)ops, (unsigned long long)first_checksum, b.operation);
+	}
+	return 0;
+}
@@ -11,21 +11,25 @@ Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
 // cubical_2dim
-Rcpp::NumericMatrix cubical_2dim(const Rcpp::NumericMatrix& image, double threshold, int method);
-RcppExport SEXP _ripserr_cubical_2dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP) {
+Rcpp::List cubical_2dim(const Rcpp::NumericMatrix& image, double threshold, int method, bool linkage, int top_k, bool stats, int threads);
+RcppExport SEXP _ripserr_cubical_2dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP linkageSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::NumericMatrix& >::type image(imageSEXP);
     Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
     Rcpp::traits::input_parameter< int >::type method(methodSEXP);
-    rcpp_result_gen = Rcpp::wrap(cubical_2dim(image, threshold, method));
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(cubical_2dim(image, threshold, method, linkage, top_k, stats, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // cubical_3dim
-Rcpp::NumericMatrix cubical_3dim(Rcpp::NumericVector& image, double threshold, int method, int nx, int ny, int nz);
-RcppExport SEXP _ripserr_cubical_3dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP nxSEXP, SEXP nySEXP, SEXP nzSEXP) {
+Rcpp::List cubical_3dim(Rcpp::NumericVector& image, double threshold, int method, int nx, int ny, int nz, bool linkage, int top_k, bool stats, int threads);
+RcppExport SEXP _ripserr_cubical_3dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP nxSEXP, SEXP nySEXP, SEXP nzSEXP, SEXP linkageSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -35,13 +39,40 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type nx(nxSEXP);
     Rcpp::traits::input_parameter< int >::type ny(nySEXP);
     Rcpp::traits::input_parameter< int >::type nz(nzSEXP);
-    rcpp_result_gen = Rcpp::wrap(cubical_3dim(image, threshold, method, nx, ny, nz));
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(cubical_3dim(image, threshold, method, nx, ny, nz, linkage, top_k, stats, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// cubical_3dim_file
+Rcpp::List cubical_3dim_file(const std::string& path, const std::string& format, const std::string& type, int nx, int ny, int nz, double threshold, int method, bool negate, bool linkage, int top_k, bool stats, int threads);
+RcppExport SEXP _ripserr_cubical_3dim_file(SEXP pathSEXP, SEXP formatSEXP, SEXP typeSEXP, SEXP nxSEXP, SEXP nySEXP, SEXP nzSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP negateSEXP, SEXP linkageSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type type(typeSEXP);
+    Rcpp::traits::input_parameter< int >::type nx(nxSEXP);
+    Rcpp::traits::input_parameter< int >::type ny(nySEXP);
+    Rcpp::traits::input_parameter< int >::type nz(nzSEXP);
+    Rcpp::traits::input_parameter< double >::type threshold(thresholdSEXP);
+    Rcpp::traits::input_parameter< int >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< bool >::type negate(negateSEXP);
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(cubical_3dim_file(path, format, type, nx, ny, nz, threshold, method, negate, linkage, top_k, stats, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // cubical_4dim
-Rcpp::NumericMatrix cubical_4dim(Rcpp::NumericVector& image, double threshold, int method, int nx, int ny, int nz, int nt);
-RcppExport SEXP _ripserr_cubical_4dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP nxSEXP, SEXP nySEXP, SEXP nzSEXP, SEXP ntSEXP) {
+Rcpp::List cubical_4dim(Rcpp::NumericVector& image, double threshold, int method, int nx, int ny, int nz, int nt, bool linkage, int top_k, bool stats, int threads);
+RcppExport SEXP _ripserr_cubical_4dim(SEXP imageSEXP, SEXP thresholdSEXP, SEXP methodSEXP, SEXP nxSEXP, SEXP nySEXP, SEXP nzSEXP, SEXP ntSEXP, SEXP linkageSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -52,31 +83,180 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< int >::type ny(nySEXP);
     Rcpp::traits::input_parameter< int >::type nz(nzSEXP);
     Rcpp::traits::input_parameter< int >::type nt(ntSEXP);
-    rcpp_result_gen = Rcpp::wrap(cubical_4dim(image, threshold, method, nx, ny, nz, nt));
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(cubical_4dim(image, threshold, method, nx, ny, nz, nt, linkage, top_k, stats, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// emst_cpp_points
+Rcpp::List emst_cpp_points(const Rcpp::NumericMatrix& points, double thresh, bool linkage, double min_persistence, int top_k, bool stats, int threads);
+RcppExport SEXP _ripserr_emst_cpp_points(SEXP pointsSEXP, SEXP threshSEXP, SEXP linkageSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix& >::type points(pointsSEXP);
+    Rcpp::traits::input_parameter< double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(emst_cpp_points(points, thresh, linkage, min_persistence, top_k, stats, threads));
     return rcpp_result_gen;
 END_RCPP
 }
 // ripser_cpp_dist
-Rcpp::List ripser_cpp_dist(const Rcpp::NumericVector& dataset, int dim, double thresh, float ratio, int p);
-RcppExport SEXP _ripserr_ripser_cpp_dist(SEXP datasetSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP) {
+Rcpp::List ripser_cpp_dist(const Rcpp::NumericVector& dataset, int dim, const Rcpp::NumericVector& thresh, float ratio, int p, bool linkage, int dim_min, bool clearing, double min_persistence, int top_k, bool stats, double max_memory, int threads);
+RcppExport SEXP _ripserr_ripser_cpp_dist(SEXP datasetSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP, SEXP linkageSEXP, SEXP dim_minSEXP, SEXP clearingSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP max_memorySEXP, SEXP threadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type dataset(datasetSEXP);
     Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
-    Rcpp::traits::input_parameter< double >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< float >::type ratio(ratioSEXP);
+    Rcpp::traits::input_parameter< int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_min(dim_minSEXP);
+    Rcpp::traits::input_parameter< bool >::type clearing(clearingSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< double >::type max_memory(max_memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_dist(dataset, dim, thresh, ratio, p, linkage, dim_min, clearing, min_persistence, top_k, stats, max_memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ripser_cpp_file
+Rcpp::List ripser_cpp_file(const std::string& path, const std::string& format, int dim, const Rcpp::NumericVector& thresh, float ratio, int p, bool linkage, int dim_min, bool clearing, double min_persistence, int top_k, bool stats, double max_memory, int threads);
+RcppExport SEXP _ripserr_ripser_cpp_file(SEXP pathSEXP, SEXP formatSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP, SEXP linkageSEXP, SEXP dim_minSEXP, SEXP clearingSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP max_memorySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
     Rcpp::traits::input_parameter< float >::type ratio(ratioSEXP);
     Rcpp::traits::input_parameter< int >::type p(pSEXP);
-    rcpp_result_gen = Rcpp::wrap(ripser_cpp_dist(dataset, dim, thresh, ratio, p));
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_min(dim_minSEXP);
+    Rcpp::traits::input_parameter< bool >::type clearing(clearingSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< double >::type max_memory(max_memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_file(path, format, dim, thresh, ratio, p, linkage, dim_min, clearing, min_persistence, top_k, stats, max_memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ripser_cpp_points
+Rcpp::List ripser_cpp_points(const Rcpp::NumericMatrix& dataset, const std::string& metric, double minkowski_p, int dim, const Rcpp::NumericVector& thresh, float ratio, int p, bool linkage, int dim_min, bool clearing, double min_persistence, int top_k, bool stats, double max_memory, int threads);
+RcppExport SEXP _ripserr_ripser_cpp_points(SEXP datasetSEXP, SEXP metricSEXP, SEXP minkowski_pSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP, SEXP linkageSEXP, SEXP dim_minSEXP, SEXP clearingSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP max_memorySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix& >::type dataset(datasetSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type metric(metricSEXP);
+    Rcpp::traits::input_parameter< double >::type minkowski_p(minkowski_pSEXP);
+    Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< float >::type ratio(ratioSEXP);
+    Rcpp::traits::input_parameter< int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_min(dim_minSEXP);
+    Rcpp::traits::input_parameter< bool >::type clearing(clearingSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< double >::type max_memory(max_memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_points(dataset, metric, minkowski_p, dim, thresh, ratio, p, linkage, dim_min, clearing, min_persistence, top_k, stats, max_memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ripser_cpp_embedding
+Rcpp::List ripser_cpp_embedding(const Rcpp::NumericMatrix& series, int data_dim, int dim_lag, int sample_lag, int dim, const Rcpp::NumericVector& thresh, float ratio, int p, bool linkage, int dim_min, bool clearing, double min_persistence, int top_k, bool stats, double max_memory, int threads);
+RcppExport SEXP _ripserr_ripser_cpp_embedding(SEXP seriesSEXP, SEXP data_dimSEXP, SEXP dim_lagSEXP, SEXP sample_lagSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP, SEXP linkageSEXP, SEXP dim_minSEXP, SEXP clearingSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP statsSEXP, SEXP max_memorySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix& >::type series(seriesSEXP);
+    Rcpp::traits::input_parameter< int >::type data_dim(data_dimSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_lag(dim_lagSEXP);
+    Rcpp::traits::input_parameter< int >::type sample_lag(sample_lagSEXP);
+    Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< float >::type ratio(ratioSEXP);
+    Rcpp::traits::input_parameter< int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< bool >::type linkage(linkageSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_min(dim_minSEXP);
+    Rcpp::traits::input_parameter< bool >::type clearing(clearingSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< bool >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< double >::type max_memory(max_memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_embedding(series, data_dim, dim_lag, sample_lag, dim, thresh, ratio, p, linkage, dim_min, clearing, min_persistence, top_k, stats, max_memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ripser_cpp_windows
+Rcpp::List ripser_cpp_windows(const Rcpp::NumericMatrix& dataset, int window, int step, int dim, const Rcpp::NumericVector& thresh, float ratio, int p, int dim_min, bool clearing, double min_persistence, int top_k, double max_memory, int threads);
+RcppExport SEXP _ripserr_ripser_cpp_windows(SEXP datasetSEXP, SEXP windowSEXP, SEXP stepSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP ratioSEXP, SEXP pSEXP, SEXP dim_minSEXP, SEXP clearingSEXP, SEXP min_persistenceSEXP, SEXP top_kSEXP, SEXP max_memorySEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericMatrix& >::type dataset(datasetSEXP);
+    Rcpp::traits::input_parameter< int >::type window(windowSEXP);
+    Rcpp::traits::input_parameter< int >::type step(stepSEXP);
+    Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< float >::type ratio(ratioSEXP);
+    Rcpp::traits::input_parameter< int >::type p(pSEXP);
+    Rcpp::traits::input_parameter< int >::type dim_min(dim_minSEXP);
+    Rcpp::traits::input_parameter< bool >::type clearing(clearingSEXP);
+    Rcpp::traits::input_parameter< double >::type min_persistence(min_persistenceSEXP);
+    Rcpp::traits::input_parameter< int >::type top_k(top_kSEXP);
+    Rcpp::traits::input_parameter< double >::type max_memory(max_memorySEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_windows(dataset, window, step, dim, thresh, ratio, p, dim_min, clearing, min_persistence, top_k, max_memory, threads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// ripser_cpp_estimate
+Rcpp::DataFrame ripser_cpp_estimate(const Rcpp::NumericVector& dataset, int dim, const Rcpp::NumericVector& thresh, int samples, int seed);
+RcppExport SEXP _ripserr_ripser_cpp_estimate(SEXP datasetSEXP, SEXP dimSEXP, SEXP threshSEXP, SEXP samplesSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type dataset(datasetSEXP);
+    Rcpp::traits::input_parameter< int >::type dim(dimSEXP);
+    Rcpp::traits::input_parameter< const Rcpp::NumericVector& >::type thresh(threshSEXP);
+    Rcpp::traits::input_parameter< int >::type samples(samplesSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(ripser_cpp_estimate(dataset, dim, thresh, samples, seed));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_ripserr_cubical_2dim", (DL_FUNC) &_ripserr_cubical_2dim, 3},
-    {"_ripserr_cubical_3dim", (DL_FUNC) &_ripserr_cubical_3dim, 6},
-    {"_ripserr_cubical_4dim", (DL_FUNC) &_ripserr_cubical_4dim, 7},
-    {"_ripserr_ripser_cpp_dist", (DL_FUNC) &_ripserr_ripser_cpp_dist, 5},
+    {"_ripserr_cubical_2dim", (DL_FUNC) &_ripserr_cubical_2dim, 7},
+    {"_ripserr_cubical_3dim", (DL_FUNC) &_ripserr_cubical_3dim, 10},
+    {"_ripserr_cubical_3dim_file", (DL_FUNC) &_ripserr_cubical_3dim_file, 13},
+    {"_ripserr_cubical_4dim", (DL_FUNC) &_ripserr_cubical_4dim, 11},
+    {"_ripserr_emst_cpp_points", (DL_FUNC) &_ripserr_emst_cpp_points, 7},
+    {"_ripserr_ripser_cpp_dist", (DL_FUNC) &_ripserr_ripser_cpp_dist, 13},
+    {"_ripserr_ripser_cpp_file", (DL_FUNC) &_ripserr_ripser_cpp_file, 14},
+    {"_ripserr_ripser_cpp_points", (DL_FUNC) &_ripserr_ripser_cpp_points, 15},
+    {"_ripserr_ripser_cpp_embedding", (DL_FUNC) &_ripserr_ripser_cpp_embedding, 16},
+    {"_ripserr_ripser_cpp_windows", (DL_FUNC) &_ripserr_ripser_cpp_windows, 13},
+    {"_ripserr_ripser_cpp_estimate", (DL_FUNC) &_ripserr_ripser_cpp_estimate, 5},
     {NULL, NULL, 0}
 };
 
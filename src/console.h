@@ -0,0 +1,76 @@
+// ripserr: console output, errors and interrupts of the engines.
+//
+// The engines are compiled into the R package and, with `RIPSERR_STANDALONE`
+// defined, into the command-line executables of cli/, which do not link R.
+// They report through these names, which refer to R's console and conditions
+// in the package and to the standard streams and exceptions otherwise.
+
+#ifndef RIPSERR_CONSOLE_H
+#define RIPSERR_CONSOLE_H
+
+#include "trace.h"
+
+namespace ripserr {
+
+// Set on the threads an engine starts to run its parts in parallel, which must
+// not call R: there, `stop()` throws a standard exception to be rethrown by the
+// calling thread, which alone checks for interrupts. (A function-local static
+// rather than an inline variable, which would need C++17.)
+inline bool& worker_thread() {
+	static thread_local bool worker = false;
+	return worker;
+}
+
+} // namespace ripserr
+
+#ifdef RIPSERR_STANDALONE
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace ripserr {
+
+static std::ostream& out = std::cout;
+static std::ostream& err = std::cerr;
+
+inline const char* format_arg(const std::string& x) { return x.c_str(); }
+template <typename T> T format_arg(T x) { return x; }
+
+// Throws the message formatted from `format` as by `printf()` (which, like
+// `Rcpp::stop()`, also accepts `std::string` arguments for `%s`).
+template <typename... Args> [[noreturn]] void stop(const char* format, const Args&... args) {
+	char message[1024];
+	std::snprintf(message, sizeof(message), format, format_arg(args)...);
+	throw std::runtime_error(message);
+}
+
+inline void check_interrupt() { RIPSERR_TRACE_INSTANT("check_interrupt"); }
+
+} // namespace ripserr
+
+#else
+
+#include <Rcpp.h>
+
+namespace ripserr {
+
+static std::ostream& out = Rcpp::Rcout;
+static std::ostream& err = Rcpp::Rcerr;
+
+template <typename... Args> [[noreturn]] void stop(const char* format, Args&&... args) {
+	if (worker_thread()) throw std::runtime_error(tfm::format(format, std::forward<Args>(args)...));
+	Rcpp::stop(format, std::forward<Args>(args)...);
+}
+
+inline void check_interrupt() {
+	RIPSERR_TRACE_INSTANT("check_interrupt");
+	Rcpp::checkUserInterrupt();
+}
+
+} // namespace ripserr
+
+#endif
+
+#endif
@@ -0,0 +1,107 @@
+// ripserr: single-linkage dendrograms recorded from union-find merges.
+//
+// The dimension 0 pass of each engine merges components in order of increasing
+// filtration value, which is exactly the single-linkage clustering of its
+// vertices. Recording each merge yields the `merge`, `height` and `order`
+// components of an `hclust` object without another clustering pass.
+
+#ifndef RIPSERR_DENDROGRAM_H
+#define RIPSERR_DENDROGRAM_H
+
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <vector>
+#ifndef RIPSERR_STANDALONE
+#include <Rcpp.h>
+#endif
+
+class dendrogram {
+	// `hclust` label of the cluster represented by each union-find root: minus
+	// the observation number for singletons, or the merge step that formed it
+	std::vector<int> label;
+	std::vector<int> left, right;
+	std::vector<double> heights;
+	int num_leaves;
+
+public:
+	// `leaves[i]` is the (1-based) observation number of union-find element `i`,
+	// or 0 for elements that are not observations (such as padding cells).
+	dendrogram(const std::vector<int>& leaves) : label(leaves.size()), num_leaves(0) {
+		for (size_t i = 0; i < leaves.size(); ++i) {
+			label[i] = -leaves[i];
+			if (leaves[i] != 0) ++num_leaves;
+		}
+		if (num_leaves > 0) {
+			left.reserve(num_leaves - 1);
+			right.reserve(num_leaves - 1);
+			heights.reserve(num_leaves - 1);
+		}
+	}
+
+	// Records the merge of the clusters with roots `u` and `v` at `height`, where
+	// `root` is the root of the merged cluster.
+	void merge(const size_t u, const size_t v, const size_t root, const double height) {
+		int a = label[u], b = label[v];
+		// as in `hclust`: singletons first, then in increasing order of label
+		if ((a > 0 && b < 0) || ((a < 0) == (b < 0) && std::abs(a) > std::abs(b))) std::swap(a, b);
+		left.push_back(a);
+		right.push_back(b);
+		heights.push_back(height);
+		label[root] = int(heights.size());
+	}
+
+	// Joins the clusters left over (disconnected below the threshold) at an
+	// infinite height, given the `find` operation of the union-find structure.
+	template <class Find> void finish(Find find) {
+		std::vector<size_t> roots;
+		std::vector<bool> seen(label.size(), false);
+		for (size_t i = 0; i < label.size(); ++i) {
+			if (label[i] == 0) continue;
+			const size_t root = find(i);
+			if (!seen[root]) roots.push_back(root);
+			seen[root] = true;
+		}
+		for (size_t k = 1; k < roots.size(); ++k)
+			merge(roots[0], roots[k], roots[0], std::numeric_limits<double>::infinity());
+	}
+
+#ifndef RIPSERR_STANDALONE
+	// The `merge`, `height` and `order` components of an `hclust` object.
+	Rcpp::List to_list() const {
+		const int n = int(heights.size());
+		Rcpp::IntegerMatrix merges(n, 2);
+		Rcpp::NumericVector height(n);
+		for (int i = 0; i < n; ++i) {
+			merges(i, 0) = left[i];
+			merges(i, 1) = right[i];
+			height[i] = heights[i];
+		}
+
+		// leaves in the order of a depth-first traversal from the last merge
+		Rcpp::IntegerVector order(num_leaves);
+		std::vector<int> stack;
+		if (n > 0)
+			stack.push_back(n);
+		else if (num_leaves == 1)
+			for (int l : label)
+				if (l < 0) stack.push_back(l);
+		int k = 0;
+		while (!stack.empty()) {
+			const int c = stack.back();
+			stack.pop_back();
+			if (c < 0) {
+				order[k++] = -c;
+			} else {
+				stack.push_back(right[c - 1]);
+				stack.push_back(left[c - 1]);
+			}
+		}
+
+		return Rcpp::List::create(Rcpp::Named("merge") = merges, Rcpp::Named("height") = height,
+		                          Rcpp::Named("order") = order);
+	}
+#endif
+};
+
+#endif
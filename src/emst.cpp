@@ -0,0 +1,39 @@
+// ripserr: The R interface of the Euclidean minimum spanning tree engine in
+// emst.h.
+
+#include "emst.h"
+#include "phom.h"
+
+// ripserr: Degree-0 persistence pairs of a Euclidean point cloud (one point per
+// row), in the format and order of `ripser_cpp_dist` with `dim = 0`, on up to
+// `threads` threads.
+// [[Rcpp::export()]]
+Rcpp::List emst_cpp_points(const Rcpp::NumericMatrix& points, double thresh, bool linkage = false,
+                           double min_persistence = 0, int top_k = 0, bool stats = false,
+                           int threads = 1) {
+	RIPSERR_TRACE_ZONE("emst_cpp_points");
+	const emst::index_t n = points.nrow();
+	engine_stats phases;
+
+	std::vector<int> leaves(linkage ? n : 0);
+	for (emst::index_t i = 0; i < emst::index_t(leaves.size()); ++i) leaves[i] = i + 1;
+	dendrogram merges(leaves);
+	std::vector<emst::value_t> deaths = emst::dim_0_deaths(points.begin(), n, points.ncol(), thresh,
+	                                                       min_persistence, top_k,
+	                                                       linkage ? &merges : nullptr,
+	                                                       stats ? &phases : nullptr, unsigned(threads));
+
+	phase_stats counts;
+	RIPSERR_TRACE_ZONE("phom_data_frame");
+	phase_timer output_phase(stats ? &phases : nullptr, counts, "output");
+	Rcpp::IntegerVector dimension(deaths.size());
+	Rcpp::NumericVector birth(dimension.size()), death(deaths.begin(), deaths.end());
+
+	Rcpp::List output = phom_data_frame(dimension, birth, death);
+	if (linkage) output.attr("dendrogram") = merges.to_list();
+	counts.columns = deaths.size();
+	output_phase.stop();
+	if (stats) output.attr("stats") = stats_data_frame(phases);
+
+	return output;
+}
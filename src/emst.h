@@ -0,0 +1,369 @@
+// ripserr: Euclidean minimum spanning trees by dual-tree Boruvka.
+//
+// The degree-0 persistence pairs of the Vietoris-Rips filtration of a Euclidean
+// point cloud are determined by the edge lengths of its minimum spanning tree.
+// The tree is found here without forming the distance matrix, following March,
+// Ram & Gray (2010) <doi:10.1145/1835804.1835882>: each Boruvka round finds the
+// shortest edge leaving every component by a simultaneous traversal of a k-d
+// tree of the points against itself, pruning pairs of nodes that lie in the
+// same component or are farther apart than the current candidates.
+//
+// The engine does not depend on R; its R interface is in emst.cpp.
+
+#ifndef RIPSERR_EMST_H
+#define RIPSERR_EMST_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <vector>
+#include "console.h"
+#include "dendrogram.h"
+#include "engine_stats.h"
+#include "top_k.h"
+#include "trace.h"
+
+namespace emst {
+
+typedef float value_t;
+typedef int32_t index_t;
+
+static const index_t leaf_size = 16;
+// smallest number of points for which the rounds are run on several threads
+static const index_t min_parallel_size = 1 << 14;
+
+// Candidate edges are compared by squared length and then by their endpoints,
+// so that all components agree on which of several equally short edges to use
+// and the merged edges never close a cycle.
+struct edge {
+	double length2;
+	index_t u, v;
+};
+
+inline bool shorter(const edge& a, const edge& b) {
+	return a.length2 < b.length2 ||
+	       (a.length2 == b.length2 && (a.u < b.u || (a.u == b.u && a.v < b.v)));
+}
+
+static const edge no_edge = {std::numeric_limits<double>::infinity(), -1, -1};
+
+class union_find {
+	std::vector<index_t> parent;
+	std::vector<uint8_t> rank;
+
+public:
+	union_find(const index_t n) : parent(n), rank(n, 0) {
+		for (index_t i = 0; i < n; ++i) parent[i] = i;
+	}
+
+	index_t find(index_t x) {
+		index_t y = x, z;
+		while ((z = parent[y]) != y) y = z;
+		while ((z = parent[x]) != y) {
+			parent[x] = y;
+			x = z;
+		}
+		return z;
+	}
+
+	void link(index_t x, index_t y) {
+		if ((x = find(x)) == (y = find(y))) return;
+		if (rank[x] > rank[y])
+			parent[y] = x;
+		else {
+			parent[x] = y;
+			if (rank[x] == rank[y]) ++rank[y];
+		}
+	}
+};
+
+// A k-d tree splitting the widest extent of each node at the median. The points
+// are stored contiguously in tree order, along with their original indices.
+class kd_tree {
+public:
+	struct node {
+		index_t begin, end, left, right;
+		bool is_leaf() const { return left == -1; }
+		index_t size() const { return end - begin; }
+	};
+
+	const index_t n, dim;
+	std::vector<double> coords;
+	std::vector<index_t> ids;
+	std::vector<node> nodes;
+	std::vector<double> lower, upper;
+
+	// `data` holds the coordinates column by column, as in an R matrix.
+	kd_tree(const double* data, const index_t _n, const index_t _dim)
+	    : n(_n), dim(_dim), coords(size_t(_n) * _dim), ids(_n) {
+		RIPSERR_TRACE_ZONE("kd_tree");
+		for (index_t i = 0; i < n; ++i) ids[i] = i;
+		if (n > 0) build(data, 0, n);
+		for (index_t k = 0; k < n; ++k)
+			for (index_t j = 0; j < dim; ++j) coords[size_t(k) * dim + j] = data[size_t(j) * n + ids[k]];
+	}
+
+	const double* point(const index_t k) const { return &coords[size_t(k) * dim]; }
+
+	// Squared distance between the bounding boxes of two nodes.
+	double box_distance2(const index_t a, const index_t b) const {
+		const double *lo_a = &lower[size_t(a) * dim], *hi_a = &upper[size_t(a) * dim],
+		             *lo_b = &lower[size_t(b) * dim], *hi_b = &upper[size_t(b) * dim];
+		double d = 0;
+		for (index_t j = 0; j < dim; ++j) {
+			const double gap = std::max(std::max(lo_b[j] - hi_a[j], lo_a[j] - hi_b[j]), 0.0);
+			d += gap * gap;
+		}
+		return d;
+	}
+
+private:
+	index_t build(const double* data, const index_t begin, const index_t end) {
+		const index_t id = index_t(nodes.size());
+		nodes.push_back({begin, end, -1, -1});
+		lower.resize(lower.size() + dim, std::numeric_limits<double>::infinity());
+		upper.resize(upper.size() + dim, -std::numeric_limits<double>::infinity());
+
+		index_t split_dim = 0;
+		double widest = -1;
+		for (index_t j = 0; j < dim; ++j) {
+			double& lo = lower[size_t(id) * dim + j];
+			double& hi = upper[size_t(id) * dim + j];
+			for (index_t k = begin; k < end; ++k) {
+				lo = std::min(lo, data[size_t(j) * n + ids[k]]);
+				hi = std::max(hi, data[size_t(j) * n + ids[k]]);
+			}
+			if (hi - lo > widest) {
+				widest = hi - lo;
+				split_dim = j;
+			}
+		}
+		if (end - begin <= leaf_size || widest <= 0) return id;
+
+		const index_t mid = begin + (end - begin) / 2;
+		const double* column = data + size_t(split_dim) * n;
+		std::nth_element(ids.begin() + begin, ids.begin() + mid, ids.begin() + end,
+		                 [column](index_t a, index_t b) { return column[a] < column[b]; });
+		const index_t left = build(data, begin, mid);
+		const index_t right = build(data, mid, end);
+		nodes[id].left = left;
+		nodes[id].right = right;
+		return id;
+	}
+};
+
+class boruvka {
+	const kd_tree& tree;
+	const index_t n;
+	union_find components;
+
+	// per round: the component of each point (in tree order), the component of
+	// each node or -1 if it spans several, and an upper bound per node on the
+	// candidate lengths of the components of its points
+	std::vector<index_t> point_component, node_component;
+	std::vector<double> bound;
+
+	void label_nodes(const index_t id) {
+		const kd_tree::node& node = tree.nodes[id];
+		if (node.is_leaf()) {
+			index_t c = point_component[node.begin];
+			for (index_t k = node.begin + 1; k < node.end && c != -1; ++k)
+				if (point_component[k] != c) c = -1;
+			node_component[id] = c;
+		} else {
+			label_nodes(node.left);
+			label_nodes(node.right);
+			const index_t c = node_component[node.left];
+			node_component[id] = (c == node_component[node.right]) ? c : -1;
+		}
+	}
+
+	void base_case(const kd_tree::node& query, const kd_tree::node& reference,
+	               std::vector<edge>& best) const {
+		const index_t dim = tree.dim;
+		for (index_t q = query.begin; q < query.end; ++q) {
+			const index_t c = point_component[q];
+			const double* x = tree.point(q);
+			for (index_t r = reference.begin; r < reference.end; ++r) {
+				if (point_component[r] == c) continue;
+				const double* y = tree.point(r);
+				double length2 = 0;
+				for (index_t j = 0; j < dim; ++j) {
+					const double dev = x[j] - y[j];
+					length2 += dev * dev;
+				}
+				const index_t u = tree.ids[q], v = tree.ids[r];
+				const edge e = {length2, std::min(u, v), std::max(u, v)};
+				if (shorter(e, best[c])) best[c] = e;
+			}
+		}
+	}
+
+	void traverse(const index_t query, const index_t reference, std::vector<edge>& best) {
+		const index_t c = node_component[query];
+		if (c != -1 && c == node_component[reference]) return;
+		if (tree.box_distance2(query, reference) > bound[query]) return;
+
+		const kd_tree::node& q = tree.nodes[query];
+		const kd_tree::node& r = tree.nodes[reference];
+		if (q.is_leaf() && r.is_leaf()) {
+			base_case(q, r, best);
+			double b = 0;
+			for (index_t k = q.begin; k < q.end; ++k)
+				b = std::max(b, best[point_component[k]].length2);
+			bound[query] = std::min(bound[query], b);
+		} else if (!q.is_leaf() && (r.is_leaf() || q.size() >= r.size())) {
+			traverse(q.left, reference, best);
+			traverse(q.right, reference, best);
+			bound[query] = std::min(bound[query], std::max(bound[q.left], bound[q.right]));
+		} else {
+			index_t near = r.left, far = r.right;
+			if (tree.box_distance2(query, far) < tree.box_distance2(query, near))
+				std::swap(near, far);
+			traverse(query, near, best);
+			traverse(query, far, best);
+		}
+	}
+
+	// Query subtrees that are traversed independently, at least `count` of them
+	// unless the tree is smaller.
+	std::vector<index_t> query_roots(const size_t count) const {
+		std::vector<index_t> roots(1, 0);
+		while (roots.size() < count) {
+			auto largest = std::max_element(roots.begin(), roots.end(), [this](index_t a, index_t b) {
+				return tree.nodes[a].size() < tree.nodes[b].size();
+			});
+			const kd_tree::node& node = tree.nodes[*largest];
+			if (node.is_leaf()) break;
+			*largest = node.left;
+			roots.push_back(node.right);
+		}
+		return roots;
+	}
+
+public:
+	boruvka(const kd_tree& _tree)
+	    : tree(_tree), n(_tree.n), components(_tree.n), point_component(_tree.n),
+	      node_component(_tree.nodes.size()), bound(_tree.nodes.size()) {}
+
+	// Merges components along their shortest outgoing edges until all points
+	// are connected or no outgoing edge has length at most `threshold`, and
+	// returns the edges of the resulting spanning forest. The rounds of large
+	// point clouds are run on up to `max_threads` threads.
+	std::vector<edge> compute(const double threshold, const unsigned max_threads = 1) {
+		RIPSERR_TRACE_ZONE("boruvka");
+		std::vector<edge> mst;
+		if (n < 2) return mst;
+
+		unsigned num_threads = n >= min_parallel_size ? std::max(1u, max_threads) : 1;
+		const std::vector<index_t> roots = query_roots(4 * num_threads);
+		num_threads = unsigned(std::min<size_t>(num_threads, roots.size()));
+		std::vector<std::vector<edge>> best(num_threads, std::vector<edge>(n));
+
+		for (index_t num_components = n; num_components > 1;) {
+			RIPSERR_TRACE_ZONE("boruvka_round");
+			ripserr::check_interrupt();
+
+			for (index_t k = 0; k < n; ++k) point_component[k] = components.find(tree.ids[k]);
+			label_nodes(0);
+			std::fill(bound.begin(), bound.end(), std::numeric_limits<double>::infinity());
+
+			// Each thread keeps its own candidates; the bounds of the nodes below
+			// a query root are only touched by the thread traversing it.
+			std::atomic<size_t> next_root(0);
+			auto work = [&](unsigned t) {
+				RIPSERR_TRACE_ZONE("traverse");
+				std::fill(best[t].begin(), best[t].end(), no_edge);
+				for (size_t i; (i = next_root++) < roots.size();) traverse(roots[i], 0, best[t]);
+			};
+			std::vector<std::thread> threads;
+			for (unsigned t = 1; t < num_threads; ++t) threads.emplace_back(work, t);
+			work(0);
+			for (auto& thread : threads) thread.join();
+
+			edge shortest = no_edge;
+			for (index_t c = 0; c < n; ++c) {
+				for (unsigned t = 1; t < num_threads; ++t)
+					if (shorter(best[t][c], best[0][c])) best[0][c] = best[t][c];
+				if (shorter(best[0][c], shortest)) shortest = best[0][c];
+			}
+			if (shortest.u == -1 || value_t(std::sqrt(shortest.length2)) > value_t(threshold)) break;
+
+			for (index_t c = 0; c < n; ++c) {
+				const edge& e = best[0][c];
+				if (e.u == -1 || components.find(e.u) == components.find(e.v)) continue;
+				components.link(e.u, e.v);
+				mst.push_back(e);
+				--num_components;
+			}
+		}
+		return mst;
+	}
+};
+
+// The degree-0 persistence pairs of the `n` points of dimension `d` (one per
+// row of the column-major array `points`), in the order of `ripser_cpp_dist`
+// with `dim = 0`: all are born at 0, and their deaths are returned. If set,
+// `merges` records the single-linkage dendrogram of the points, and `stats` the
+// timings of building the tree and of finding the spanning tree, which runs on
+// up to `num_threads` threads.
+inline std::vector<value_t> dim_0_deaths(const double* points, const index_t n, const index_t d,
+                                         const double thresh, const double min_persistence,
+                                         const int top_k, dendrogram* merges,
+                                         engine_stats* stats = nullptr, unsigned num_threads = 1) {
+	phase_stats counts;
+	RIPSERR_TRACE_ZONE("dim_0_deaths", 0);
+	phase_timer tree_phase(stats, counts, "kd_tree", 0);
+	kd_tree tree(points, n, d);
+	counts.columns = n;
+	tree_phase.stop();
+	phase_timer mst_phase(stats, counts, "mst", 0);
+	std::vector<edge> mst = boruvka(tree).compute(thresh, num_threads);
+	counts.columns = mst.size();
+	mst_phase.stop();
+
+	std::vector<value_t> deaths;
+	index_t num_components = n;
+	for (const edge& e : mst) {
+		const value_t death = value_t(std::sqrt(e.length2));
+		if (death > value_t(thresh)) continue;
+		--num_components;
+		if (death != 0 && death >= value_t(min_persistence)) deaths.push_back(death);
+	}
+	std::sort(deaths.begin(), deaths.end());
+
+	// if requested, only the most persistent pairs, in order of decreasing persistence
+	if (top_k > 0) {
+		most_persistent<value_t> top;
+		auto persistence = [](value_t death) { return death; };
+		for (value_t death : deaths) push_most_persistent(top, death, top_k, persistence);
+		for (; num_components > 0; --num_components)
+			push_most_persistent(top, std::numeric_limits<value_t>::infinity(), top_k, persistence);
+		deaths.clear();
+		append_most_persistent(top, deaths, persistence);
+	}
+	deaths.resize(deaths.size() + num_components, std::numeric_limits<value_t>::infinity());
+
+	if (merges) {
+		// the single-linkage dendrogram, merging along the tree edges in order
+		union_find components(n);
+		std::sort(mst.begin(), mst.end(), shorter);
+		for (const edge& e : mst) {
+			const value_t death = value_t(std::sqrt(e.length2));
+			if (death > value_t(thresh)) break;
+			const index_t u = components.find(e.u), v = components.find(e.v);
+			components.link(u, v);
+			merges->merge(u, v, components.find(u), death);
+		}
+		merges->finish([&](index_t i) { return components.find(i); });
+	}
+
+	return deaths;
+}
+
+} // namespace emst
+
+#endif
@@ -0,0 +1,109 @@
+// ripserr: per-phase timings and counters of the engines (`stats = TRUE`).
+//
+// Each engine counts its work in the `phase_stats` of the phase it is in, which
+// a `phase_timer` resets when the phase starts and, if statistics were
+// requested, appends with its wall time to the `engine_stats` when it ends. The
+// counters are incremented whether or not statistics were requested, which
+// costs less than testing for it.
+
+#ifndef RIPSERR_ENGINE_STATS_H
+#define RIPSERR_ENGINE_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifndef RIPSERR_STANDALONE
+#include <Rcpp.h>
+#endif
+
+struct phase_stats {
+	std::string phase;
+	// the dimension of the columns (simplices or cubes) of the phase, or -1
+	int dim = -1;
+	double seconds = 0;
+	// columns assembled or reduced (or edges processed, in dimension 0)
+	uint64_t columns = 0;
+	// columns paired without reduction: skipped for lying in apparent pairs, or
+	// paired with an emergent (or apparent) pivot on their first coboundary
+	uint64_t apparent_pairs = 0, emergent_pairs = 0;
+	// coboundaries of other columns added during reduction
+	uint64_t additions = 0;
+	// entries pushed onto the working columns (heaps)
+	uint64_t heap_pushes = 0;
+	// the largest number of entries held by the working columns of a column
+	uint64_t peak_scratch = 0;
+
+	void scratch(const size_t size) {
+		if (size > peak_scratch) peak_scratch = size;
+	}
+};
+
+struct engine_stats {
+	std::vector<phase_stats> phases;
+};
+
+// Times a phase from its construction to its destruction (or `stop()`),
+// counting its work in `counts`.
+class phase_timer {
+	engine_stats* stats;
+	phase_stats& counts;
+	std::chrono::steady_clock::time_point start;
+
+public:
+	phase_timer(engine_stats* _stats, phase_stats& _counts, const char* phase, const int dim = -1)
+	    : stats(_stats), counts(_counts), start(std::chrono::steady_clock::now()) {
+		counts = phase_stats();
+		counts.phase = phase;
+		counts.dim = dim;
+	}
+
+	~phase_timer() { stop(); }
+
+	// Ends the phase before the timer is destroyed.
+	void stop() {
+		if (!stats) return;
+		counts.seconds =
+		    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		stats->phases.push_back(counts);
+		stats = nullptr;
+	}
+
+	phase_timer(const phase_timer&) = delete;
+	phase_timer& operator=(const phase_timer&) = delete;
+};
+
+#ifndef RIPSERR_STANDALONE
+
+// Returns the phases as a data frame with one row per phase, in order.
+inline Rcpp::DataFrame stats_data_frame(const engine_stats& stats) {
+	const size_t n = stats.phases.size();
+	Rcpp::CharacterVector phase(n);
+	Rcpp::IntegerVector dim(n);
+	Rcpp::NumericVector seconds(n), columns(n), apparent_pairs(n), emergent_pairs(n), additions(n),
+	    heap_pushes(n), peak_scratch(n);
+	for (size_t i = 0; i < n; ++i) {
+		const phase_stats& p = stats.phases[i];
+		phase[i] = p.phase;
+		dim[i] = p.dim < 0 ? NA_INTEGER : p.dim;
+		seconds[i] = p.seconds;
+		// doubles, since the counts may exceed the range of R integers
+		columns[i] = double(p.columns);
+		apparent_pairs[i] = double(p.apparent_pairs);
+		emergent_pairs[i] = double(p.emergent_pairs);
+		additions[i] = double(p.additions);
+		heap_pushes[i] = double(p.heap_pushes);
+		peak_scratch[i] = double(p.peak_scratch);
+	}
+	return Rcpp::DataFrame::create(
+	    Rcpp::Named("phase") = phase, Rcpp::Named("dim") = dim, Rcpp::Named("seconds") = seconds,
+	    Rcpp::Named("columns") = columns, Rcpp::Named("apparent_pairs") = apparent_pairs,
+	    Rcpp::Named("emergent_pairs") = emergent_pairs, Rcpp::Named("additions") = additions,
+	    Rcpp::Named("heap_pushes") = heap_pushes, Rcpp::Named("peak_scratch") = peak_scratch,
+	    Rcpp::Named("stringsAsFactors") = false);
+}
+
+#endif
+
+#endif
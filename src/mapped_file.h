@@ -0,0 +1,94 @@
+// ripserr: read-only memory mappings of input files.
+//
+// Large inputs (such as distance matrices of tens of thousands of points) are
+// read in place from the page cache rather than copied into the R heap, so
+// that they are held in memory once however many jobs read them.
+
+#ifndef RIPSERR_MAPPED_FILE_H
+#define RIPSERR_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include "console.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class mapped_file {
+	char* begin = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	HANDLE mapping = NULL;
+#endif
+
+public:
+	explicit mapped_file(const std::string& path) {
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		                          FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE) ripserr::stop("cannot open file '%s'", path);
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			ripserr::stop("cannot read the size of file '%s'", path);
+		}
+		length = size_t(size.QuadPart);
+		if (length > 0) {
+			mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL) begin = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+		CloseHandle(file);
+		if (length > 0 && begin == nullptr) {
+			if (mapping != NULL) CloseHandle(mapping);
+			ripserr::stop("cannot map file '%s' into memory", path);
+		}
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1) ripserr::stop("cannot open file '%s'", path);
+		struct stat st;
+		if (fstat(fd, &st) == -1) {
+			close(fd);
+			ripserr::stop("cannot read the size of file '%s'", path);
+		}
+		length = size_t(st.st_size);
+		if (length > 0) {
+			// shared, so that concurrent jobs read the same pages of the cache
+			void* address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+			if (address != MAP_FAILED) begin = static_cast<char*>(address);
+		}
+		close(fd);
+		if (length > 0 && begin == nullptr) ripserr::stop("cannot map file '%s' into memory", path);
+#endif
+	}
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	~mapped_file() {
+		if (begin == nullptr) return;
+#ifdef _WIN32
+		UnmapViewOfFile(begin);
+		CloseHandle(mapping);
+#else
+		munmap(begin, length);
+#endif
+	}
+
+	// The mapped bytes are read-only: writing to them is an access violation.
+	char* data() const { return begin; }
+	size_t size() const { return length; }
+};
+
+#endif
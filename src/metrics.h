@@ -0,0 +1,238 @@
+// ripserr: distances between the points of a point cloud under the metrics of
+// `vietoris_rips()`, written as single-precision distances straight into the
+// distance matrices of the engine.
+//
+// The points are read in place as the columns of a column-major array (as in
+// an R matrix), so that each coordinate of the points before point `i` is
+// contiguous: row `i` of the distance matrix accumulates, in double precision,
+// one coordinate of all the earlier points at a time, which the kernels below
+// vectorize across points. The coordinates are accumulated in order, as by
+// `stats::dist()`, so that its distances are reproduced exactly.
+
+#ifndef RIPSERR_METRICS_H
+#define RIPSERR_METRICS_H
+
+#include "ripser.h"
+
+namespace vr {
+
+enum point_metric { EUCLIDEAN, MANHATTAN, CHEBYSHEV, MINKOWSKI, COSINE, CORRELATION };
+
+// The combination of the coordinates `x` of the current point and `column[j]`
+// of each earlier point `j` into the accumulated `row[j]`.
+enum accumulation { SQUARED_DIFFERENCE, ABSOLUTE_DIFFERENCE, MAXIMUM_DIFFERENCE, PRODUCT };
+
+// Accumulation kernel `accumulate_row(op, row, column, x, len)`.
+
+typedef void (*accumulate_row_t)(accumulation, double*, const double*, double, size_t);
+
+inline void accumulate_row_scalar(accumulation op, double* row, const double* column, double x, size_t len) {
+	switch (op) {
+	case SQUARED_DIFFERENCE:
+		for (size_t j = 0; j < len; ++j) row[j] += (column[j] - x) * (column[j] - x);
+		break;
+	case ABSOLUTE_DIFFERENCE:
+		for (size_t j = 0; j < len; ++j) row[j] += std::abs(column[j] - x);
+		break;
+	case MAXIMUM_DIFFERENCE:
+		for (size_t j = 0; j < len; ++j) row[j] = std::max(row[j], std::abs(column[j] - x));
+		break;
+	case PRODUCT:
+		for (size_t j = 0; j < len; ++j) row[j] += column[j] * x;
+		break;
+	}
+}
+
+#ifdef RIPSER_X86_DISPATCH
+
+inline __attribute__((target("sse2"))) void accumulate_row_sse2(accumulation op, double* row,
+                                                                 const double* column, double x,
+                                                                 size_t len) {
+	const __m128d xs = _mm_set1_pd(x), sign = _mm_set1_pd(-0.0);
+	size_t j = 0;
+	for (; j + 2 <= len; j += 2) {
+		const __m128d c = _mm_loadu_pd(column + j), r = _mm_loadu_pd(row + j);
+		const __m128d d = _mm_sub_pd(c, xs);
+		switch (op) {
+		case SQUARED_DIFFERENCE: _mm_storeu_pd(row + j, _mm_add_pd(r, _mm_mul_pd(d, d))); break;
+		case ABSOLUTE_DIFFERENCE: _mm_storeu_pd(row + j, _mm_add_pd(r, _mm_andnot_pd(sign, d))); break;
+		case MAXIMUM_DIFFERENCE: _mm_storeu_pd(row + j, _mm_max_pd(r, _mm_andnot_pd(sign, d))); break;
+		case PRODUCT: _mm_storeu_pd(row + j, _mm_add_pd(r, _mm_mul_pd(c, xs))); break;
+		}
+	}
+	accumulate_row_scalar(op, row + j, column + j, x, len - j);
+}
+
+inline __attribute__((target("avx"))) void accumulate_row_avx(accumulation op, double* row,
+                                                               const double* column, double x,
+                                                               size_t len) {
+	const __m256d xs = _mm256_set1_pd(x), sign = _mm256_set1_pd(-0.0);
+	size_t j = 0;
+	for (; j + 4 <= len; j += 4) {
+		const __m256d c = _mm256_loadu_pd(column + j), r = _mm256_loadu_pd(row + j);
+		const __m256d d = _mm256_sub_pd(c, xs);
+		switch (op) {
+		case SQUARED_DIFFERENCE: _mm256_storeu_pd(row + j, _mm256_add_pd(r, _mm256_mul_pd(d, d))); break;
+		case ABSOLUTE_DIFFERENCE:
+			_mm256_storeu_pd(row + j, _mm256_add_pd(r, _mm256_andnot_pd(sign, d)));
+			break;
+		case MAXIMUM_DIFFERENCE:
+			_mm256_storeu_pd(row + j, _mm256_max_pd(r, _mm256_andnot_pd(sign, d)));
+			break;
+		case PRODUCT: _mm256_storeu_pd(row + j, _mm256_add_pd(r, _mm256_mul_pd(c, xs))); break;
+		}
+	}
+	accumulate_row_scalar(op, row + j, column + j, x, len - j);
+}
+
+#endif
+
+inline accumulate_row_t select_accumulate_row() {
+#ifdef RIPSER_X86_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx")) return accumulate_row_avx;
+	if (__builtin_cpu_supports("sse2")) return accumulate_row_sse2;
+#endif
+	return accumulate_row_scalar;
+}
+
+static const accumulate_row_t accumulate_row = select_accumulate_row();
+
+// The distances under `metric` between the `n` points of dimension `d` stored
+// as the columns of `columns`, which must outlive it; the Minkowski distance
+// takes the exponent `p`, and is the Manhattan, Euclidean or Chebyshev distance
+// for `p` of 1, 2 or infinity. The cosine and correlation distances are 1 less
+// the cosine of the angle between the points, taken as vectors or centered
+// about their means; the points must not be 0, or constant, respectively.
+class point_cloud_metric {
+	const double* columns;
+	index_t n, d;
+	point_metric metric;
+	double p;
+	// the points scaled to norm 1 (and centered), for the cosine and correlation
+	std::vector<double> normalized;
+
+public:
+	point_cloud_metric(const double* _columns, index_t _n, index_t _d, point_metric _metric, double _p = 2)
+	    : columns(_columns), n(_n), d(_d), metric(_metric), p(_p) {
+		if (metric == MINKOWSKI) {
+			if (p == 1) metric = MANHATTAN;
+			if (p == 2) metric = EUCLIDEAN;
+			if (std::isinf(p)) metric = CHEBYSHEV;
+		}
+		if (metric == COSINE || metric == CORRELATION) {
+			normalized.assign(columns, columns + size_t(n) * d);
+			for (index_t i = 0; i < n; ++i) {
+				double mean = 0, norm = 0;
+				if (metric == CORRELATION) {
+					for (index_t c = 0; c < d; ++c) mean += columns[size_t(c) * n + i];
+					mean /= d;
+				}
+				for (index_t c = 0; c < d; ++c) {
+					double& x = normalized[size_t(c) * n + i];
+					x -= mean;
+					norm += x * x;
+				}
+				if (!(norm > 0))
+					ripserr::stop("the %s distance is undefined for %s points",
+					              metric == COSINE ? "cosine" : "correlation",
+					              metric == COSINE ? "zero" : "constant");
+				norm = std::sqrt(norm);
+				for (index_t c = 0; c < d; ++c) normalized[size_t(c) * n + i] /= norm;
+			}
+			columns = normalized.data();
+		}
+	}
+
+	index_t size() const { return n; }
+
+	// Writes the distances from point `i` to the points before it to `row`,
+	// given the scratch space `sums` of as many values.
+	void row_distances(index_t i, double* sums, value_t* row) const {
+		const accumulation op = metric == EUCLIDEAN      ? SQUARED_DIFFERENCE
+		                        : metric == MANHATTAN   ? ABSOLUTE_DIFFERENCE
+		                        : metric == CHEBYSHEV   ? MAXIMUM_DIFFERENCE
+		                        : metric == MINKOWSKI   ? ABSOLUTE_DIFFERENCE
+		                                                : PRODUCT;
+		std::fill(sums, sums + i, 0.0);
+		for (index_t c = 0; c < d; ++c) {
+			const double* column = columns + size_t(c) * n;
+			if (metric == MINKOWSKI)
+				for (index_t j = 0; j < i; ++j) sums[j] += std::pow(std::abs(column[j] - column[i]), p);
+			else
+				accumulate_row(op, sums, column, column[i], size_t(i));
+		}
+		switch (metric) {
+		case EUCLIDEAN:
+			for (index_t j = 0; j < i; ++j) row[j] = value_t(std::sqrt(sums[j]));
+			break;
+		case MINKOWSKI:
+			for (index_t j = 0; j < i; ++j) row[j] = value_t(std::pow(sums[j], 1 / p));
+			break;
+		case COSINE:
+		case CORRELATION:
+			for (index_t j = 0; j < i; ++j) row[j] = value_t(std::max(1 - sums[j], 0.0));
+			break;
+		default:
+			for (index_t j = 0; j < i; ++j) row[j] = value_t(sums[j]);
+		}
+	}
+};
+
+// The distance matrix of the points of `metric`.
+inline compressed_lower_distance_matrix metric_distance_matrix(const point_cloud_metric& metric) {
+	RIPSERR_TRACE_ZONE("metric_distance_matrix");
+	const index_t n = metric.size();
+	std::vector<value_t> distances(size_t(n) * (n - 1) / 2);
+	std::vector<double> sums(n);
+	value_t* row = distances.data();
+	for (index_t i = 1; i < n; row += i++) metric.row_distances(i, sums.data(), row);
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+// The distances of the points of `metric` up to `threshold`, without forming
+// their distance matrix: the neighbors below each point are collected row by
+// row and then merged with those above it.
+inline sparse_distance_matrix metric_sparse_distance_matrix(const point_cloud_metric& metric,
+                                                            value_t threshold) {
+	RIPSERR_TRACE_ZONE("metric_sparse_distance_matrix");
+	const index_t n = metric.size();
+	assert(n <= index_t(std::numeric_limits<int32_t>::max()));
+	std::vector<size_t> below_offsets(n + 1, 0), degrees(n, 0);
+	std::vector<int32_t> below_indices;
+	std::vector<value_t> below_diameters;
+	std::vector<double> sums(n);
+	std::vector<value_t> row(n);
+	for (index_t i = 1; i < n; ++i) {
+		metric.row_distances(i, sums.data(), row.data());
+		for (index_t j = 0; j < i; ++j)
+			if (row[j] <= threshold) {
+				below_indices.push_back(int32_t(j));
+				below_diameters.push_back(row[j]);
+				++degrees[i];
+				++degrees[j];
+			}
+		below_offsets[i + 1] = below_indices.size();
+	}
+
+	// the neighbors below each point, in order, precede those above it, which
+	// are appended in order as the rows are visited
+	std::vector<size_t> offsets(n + 1, 0);
+	for (index_t i = 0; i < n; ++i) offsets[i + 1] = offsets[i] + degrees[i];
+	std::vector<int32_t> indices(offsets.back());
+	std::vector<value_t> diameters(offsets.back());
+	std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+	for (index_t i = 1; i < n; ++i)
+		for (size_t e = below_offsets[i]; e < below_offsets[i + 1]; ++e) {
+			const index_t j = below_indices[e];
+			indices[next[i]] = int32_t(j);
+			diameters[next[i]++] = below_diameters[e];
+			indices[next[j]] = int32_t(i);
+			diameters[next[j]++] = below_diameters[e];
+		}
+	return sparse_distance_matrix(std::move(offsets), std::move(indices), std::move(diameters));
+}
+
+} // namespace vr
+
+#endif
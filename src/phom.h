@@ -0,0 +1,78 @@
+// ripserr: persistence data returned to R as `PHom` data frames.
+//
+// The engines know the number of pairs of each dimension once they are done,
+// so the columns of the final data frame are sized and filled in a single pass
+// rather than assembled in R from one matrix per dimension. (Only the selection
+// of the pairs is available to the standalone executables.)
+
+#ifndef RIPSERR_PHOM_H
+#define RIPSERR_PHOM_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "engine_stats.h"
+#include "trace.h"
+#ifndef RIPSERR_STANDALONE
+#include <Rcpp.h>
+#endif
+
+// Returns the index among the pairs written by a cubical engine of the feature
+// of the whole image (dimension -1, born at `min_value` and persisting to
+// `threshold`), which carries no information, or `pairs.size()` if there is no
+// unique such feature.
+template <class WritePairs>
+size_t whole_image_pair(std::vector<WritePairs>& pairs, const double min_value, const double threshold) {
+	auto whole_image = [&](WritePairs& p) {
+		return p.getDimension() == -1 && std::abs(p.getBirth() - min_value) < 1e-6 &&
+		       std::abs(p.getDeath() - threshold) < 1e-6;
+	};
+	if (std::count_if(pairs.begin(), pairs.end(), whole_image) != 1) return pairs.size();
+	return std::find_if(pairs.begin(), pairs.end(), whole_image) - pairs.begin();
+}
+
+#ifndef RIPSERR_STANDALONE
+
+// Returns a `PHom` object (see `new_PHom()` in R/PHom.R) with the given columns,
+// which must have equal lengths.
+inline Rcpp::List phom_data_frame(const Rcpp::IntegerVector& dimension, const Rcpp::NumericVector& birth,
+                                  const Rcpp::NumericVector& death) {
+	Rcpp::List phom = Rcpp::List::create(Rcpp::Named("dimension") = dimension, Rcpp::Named("birth") = birth,
+	                                     Rcpp::Named("death") = death);
+	// compact row names 1..n, as `data.frame()` sets them
+	phom.attr("row.names") = Rcpp::IntegerVector::create(NA_INTEGER, -int(dimension.size()));
+	phom.attr("class") = Rcpp::CharacterVector::create("PHom", "data.frame");
+	return phom;
+}
+
+// Returns the pairs written by a cubical engine as a `PHom` object, without the
+// feature of the whole image (see `whole_image_pair()`). If set, `stats` gains
+// the phase of this conversion and is attached to the object.
+template <class WritePairs>
+Rcpp::List cubical_phom_data_frame(std::vector<WritePairs>& pairs, const double min_value,
+                                   const double threshold, engine_stats* stats = nullptr) {
+	phase_stats counts;
+	RIPSERR_TRACE_ZONE("cubical_phom_data_frame");
+	phase_timer output_phase(stats, counts, "output");
+	const size_t skip = whole_image_pair(pairs, min_value, threshold);
+
+	const size_t num_pairs = pairs.size() - (skip < pairs.size() ? 1 : 0);
+	Rcpp::IntegerVector dimension(num_pairs);
+	Rcpp::NumericVector birth(num_pairs), death(num_pairs);
+	for (size_t i = 0, row = 0; i < pairs.size(); ++i) {
+		if (i == skip) continue;
+		dimension[row] = int(pairs[i].getDimension());
+		birth[row] = pairs[i].getBirth();
+		death[row] = pairs[i].getDeath();
+		++row;
+	}
+	Rcpp::List phom = phom_data_frame(dimension, birth, death);
+	counts.columns = num_pairs;
+	output_phase.stop();
+	if (stats) phom.attr("stats") = stats_data_frame(*stats);
+	return phom;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,168 @@
+// ripserr: LSD radix sort on packed unsigned sort keys.
+//
+// The engines order their columns by decreasing filtration value and then by
+// increasing index. Both fields map order-preservingly onto unsigned integers,
+// so a column can be packed into a single key whose unsigned order is the
+// column order. Such keys are sorted here one byte at a time, least significant
+// byte first, and decoded back by the caller.
+
+#ifndef RIPSERR_RADIX_SORT_H
+#define RIPSERR_RADIX_SORT_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace radix {
+
+// Order-preserving bijections between signed or floating-point values and
+// unsigned integers. Negative zero is folded onto positive zero, because
+// comparisons treat them as equal.
+
+inline uint32_t ordered_bits(float x) {
+	uint32_t u;
+	x += 0.0f;
+	std::memcpy(&u, &x, sizeof(u));
+	return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+inline uint64_t ordered_bits(double x) {
+	uint64_t u;
+	x += 0.0;
+	std::memcpy(&u, &x, sizeof(u));
+	return (u & 0x8000000000000000u) ? ~u : (u | 0x8000000000000000u);
+}
+
+inline uint32_t ordered_bits(int32_t i) { return uint32_t(i) ^ 0x80000000u; }
+inline uint64_t ordered_bits(int64_t i) { return uint64_t(i) ^ 0x8000000000000000u; }
+
+inline float float_from_ordered_bits(uint32_t u) {
+	u = (u & 0x80000000u) ? (u & 0x7fffffffu) : ~u;
+	float x;
+	std::memcpy(&x, &u, sizeof(x));
+	return x;
+}
+
+inline double double_from_ordered_bits(uint64_t u) {
+	u = (u & 0x8000000000000000u) ? (u & 0x7fffffffffffffffu) : ~u;
+	double x;
+	std::memcpy(&x, &u, sizeof(x));
+	return x;
+}
+
+inline int32_t int32_from_ordered_bits(uint32_t u) { return int32_t(u ^ 0x80000000u); }
+inline int64_t int64_from_ordered_bits(uint64_t u) { return int64_t(u ^ 0x8000000000000000u); }
+
+// A 96-bit key, for a 64-bit value with a 32-bit index or vice versa.
+struct key96 {
+	uint64_t hi;
+	uint32_t lo;
+	bool operator<(const key96& other) const {
+		return hi < other.hi || (hi == other.hi && lo < other.lo);
+	}
+};
+
+template <typename Key> struct key_traits;
+
+template <> struct key_traits<uint64_t> {
+	static const int num_digits = 8;
+	static unsigned digit(const uint64_t& k, int d) { return unsigned(k >> (8 * d)) & 0xff; }
+};
+
+template <> struct key_traits<key96> {
+	static const int num_digits = 12;
+	static unsigned digit(const key96& k, int d) {
+		return d < 4 ? unsigned(k.lo >> (8 * d)) & 0xff : unsigned(k.hi >> (8 * (d - 4))) & 0xff;
+	}
+};
+
+// below this size, a comparison sort is faster than the counting passes
+static const size_t min_radix_size = 1 << 10;
+// smallest number of keys worth handing to a separate thread
+static const size_t min_keys_per_thread = 1 << 16;
+
+template <class Function> void run_in_parallel(unsigned num_threads, Function f) {
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < num_threads; ++t) threads.emplace_back(f, t);
+	f(0);
+	for (auto& thread : threads) thread.join();
+}
+
+// Sorts `keys` into increasing order. Each pass scatters the keys stably by one
+// byte; passes in which all keys share the same byte are skipped. Large inputs
+// are split into contiguous chunks that are counted and scattered by up to
+// `max_threads` threads, the per-chunk offsets keeping every pass stable.
+template <typename Key> void sort(std::vector<Key>& keys, unsigned max_threads = 1) {
+	typedef key_traits<Key> traits;
+	typedef std::array<size_t, 256> histogram;
+
+	const size_t n = keys.size();
+	if (n < min_radix_size) {
+		std::sort(keys.begin(), keys.end());
+		return;
+	}
+
+	unsigned num_threads = unsigned(std::min<size_t>(max_threads, n / min_keys_per_thread));
+	num_threads = std::max(1u, num_threads);
+	auto chunk_begin = [&](unsigned t) { return n * t / num_threads; };
+
+	// A single read of the input yields the histograms of all digits, which
+	// identifies the passes that would leave the keys in place.
+	std::vector<std::array<histogram, traits::num_digits>> counts(num_threads);
+	run_in_parallel(num_threads, [&](unsigned t) {
+		auto& count = counts[t];
+		for (auto& c : count) c.fill(0);
+		for (size_t i = chunk_begin(t), end = chunk_begin(t + 1); i < end; ++i)
+			for (int d = 0; d < traits::num_digits; ++d) ++count[d][traits::digit(keys[i], d)];
+	});
+
+	std::vector<Key> buffer(n);
+	Key* from = keys.data();
+	Key* to = buffer.data();
+	std::vector<histogram> offsets(num_threads);
+	bool scattered = false;
+
+	for (int d = 0; d < traits::num_digits; ++d) {
+		bool trivial = false;
+		for (unsigned b = 0; b < 256 && !trivial; ++b) {
+			size_t total = 0;
+			for (unsigned t = 0; t < num_threads; ++t) total += counts[t][d][b];
+			trivial = (total == n);
+		}
+		if (trivial) continue;
+
+		// Per-chunk histograms of this digit for the current arrangement of the
+		// keys; until the first scatter, the initial counts are still valid.
+		if (num_threads > 1 && scattered)
+			run_in_parallel(num_threads, [&](unsigned t) {
+				auto& count = counts[t][d];
+				count.fill(0);
+				for (size_t i = chunk_begin(t), end = chunk_begin(t + 1); i < end; ++i)
+					++count[traits::digit(from[i], d)];
+			});
+
+		size_t offset = 0;
+		for (unsigned b = 0; b < 256; ++b)
+			for (unsigned t = 0; t < num_threads; ++t) {
+				offsets[t][b] = offset;
+				offset += counts[t][d][b];
+			}
+
+		run_in_parallel(num_threads, [&](unsigned t) {
+			auto& offset = offsets[t];
+			for (size_t i = chunk_begin(t), end = chunk_begin(t + 1); i < end; ++i)
+				to[offset[traits::digit(from[i], d)]++] = from[i];
+		});
+		std::swap(from, to);
+		scattered = true;
+	}
+
+	if (from != keys.data()) std::copy(from, from + n, keys.data());
+}
+
+} // namespace radix
+
+#endif
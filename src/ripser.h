@@ -0,0 +1,2117 @@
+/*
+ This file is an altered form of the Ripser software created by Ulrich Bauer.
+ Details of the original software are below the dashed line.
+ -Raoul Wadhwa & Jason Cory Brunson
+
+ This header holds the engine, which does not depend on R; its R and
+ command-line interfaces are in ripser.cpp.
+ -------------------------------------------------------------------------------
+ Ripser: a lean C++ code for computation of Vietoris-Rips persistence barcodes
+
+ MIT License
+
+ Copyright (c) 2015–2021 Ulrich Bauer
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ You are under no obligation whatsoever to provide any bug fixes, patches, or
+ upgrades to the features, functionality or performance of the source code
+ ("Enhancements") to anyone; however, if you choose to make your Enhancements
+ available either publicly, or directly to the author of this software, without
+ imposing a separate written license agreement for such Enhancements, then you
+ hereby grant the following license: a non-exclusive, royalty-free perpetual
+ license to install, use, modify, prepare derivative works, incorporate into
+ other computer software, distribute, and sublicense such enhancements or
+ derivative works thereof, in binary and source code form.
+
+*/
+
+#ifndef RIPSERR_RIPSER_H
+#define RIPSERR_RIPSER_H
+
+//#define USE_COEFFICIENTS
+
+//#define INDICATE_PROGRESS
+// ripserq: Don't print pairs (accumulate them instead).
+//#define PRINT_PERSISTENCE_PAIRS
+
+// ripserq: Accumulate pairs in an object to be returned to the user.
+#define COLLECT_PERSISTENCE_PAIRS
+
+//#define USE_ROBINHOOD_HASHMAP
+
+// ripserq: R package need not read files.
+//#define INPUT_TYPE
+
+// ripserr: Builds without R (see cli/) read files.
+#ifdef RIPSERR_STANDALONE
+#define INPUT_TYPE
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+// ripserq
+#include "console.h"
+#include "dendrogram.h"
+#include "engine_stats.h"
+#include "mapped_file.h"
+#include "radix_sort.h"
+#include "top_k.h"
+#include "trace.h"
+
+#ifdef USE_ROBINHOOD_HASHMAP
+#include "robin-hood-hashing/src/include/robin_hood.h"
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RIPSER_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+// ripserr: The engine has its own namespace, so that it can be compiled along
+// with the others (see ripserr.h).
+namespace vr {
+
+#ifdef USE_ROBINHOOD_HASHMAP
+
+template <class Key, class T, class H, class E>
+using hash_map = robin_hood::unordered_map<Key, T, H, E>;
+template <class Key> using hash = robin_hood::hash<Key>;
+
+#else
+
+template <class Key, class T, class H, class E> using hash_map = std::unordered_map<Key, T, H, E>;
+template <class Key> using hash = std::hash<Key>;
+
+#endif
+
+typedef float value_t;
+typedef int64_t index_t;
+typedef uint16_t coefficient_t;
+
+#ifdef INDICATE_PROGRESS
+static const std::chrono::milliseconds time_step(40);
+#endif
+
+static const std::string clear_line("\r\033[K");
+
+static const size_t num_coefficient_bits = 8;
+
+// Simplex indices are stored with the integer type `Index`, which is 64-bit by
+// default but may be narrowed to 32-bit when every index of the filtration fits
+// (see `index_fits`); vertex indices and counts always use `index_t`.
+
+template <typename Index> Index max_simplex_index() {
+#ifdef USE_COEFFICIENTS
+	return (Index(1) << (8 * sizeof(Index) - 1 - num_coefficient_bits)) - 1;
+#else
+	return std::numeric_limits<Index>::max();
+#endif
+}
+
+template <typename Index> void check_overflow(Index i) {
+	if
+#ifdef USE_COEFFICIENTS
+	    (i > max_simplex_index<Index>())
+#else
+	    (i < 0)
+#endif
+		throw std::overflow_error("simplex index " + std::to_string((uint64_t)i) +
+		                          " in filtration is larger than maximum index " +
+		                          std::to_string(max_simplex_index<Index>()));
+}
+
+// Whether the binomial coefficients needed for simplices of dimension up to
+// `k - 1` on `n` vertices, the largest of which is C(n, min(n / 2, k)), fit in
+// the simplex index type `Index`.
+template <typename Index> bool index_fits(const index_t n, const index_t k) {
+	const index_t m = std::min(n / 2, k);
+	index_t c = 1;
+	for (index_t i = 1; i <= m; ++i) {
+		c = c * (n - m + i) / i;
+		if (c > index_t(max_simplex_index<Index>())) return false;
+	}
+	return true;
+}
+
+template <typename Index> class binomial_coeff_table {
+	std::vector<std::vector<Index>> B;
+	
+
+public:
+	binomial_coeff_table(index_t n, index_t k) : B(k + 1, std::vector<Index>(n + 1, 0)) {
+		for (index_t i = 0; i <= n; ++i) {
+			B[0][i] = 1;
+			for (index_t j = 1; j < std::min(i, k + 1); ++j)
+				B[j][i] = B[j - 1][i - 1] + B[j][i - 1];
+			if (i <= k) B[i][i] = 1;
+			check_overflow(B[std::min(i >> 1, k)][i]);
+		}
+	}
+
+	Index operator()(index_t n, index_t k) const {
+		assert(k < B.size() && n < B[k].size() && n >= k - 1);
+		return B[k][n];
+	}
+};
+
+inline bool is_prime(const coefficient_t n) {
+	if (!(n & 1) || n < 2) return n == 2;
+	for (coefficient_t p = 3; p <= n / p; p += 2)
+		if (!(n % p)) return false;
+	return true;
+}
+
+inline std::vector<coefficient_t> multiplicative_inverse_vector(const coefficient_t m) {
+	std::vector<coefficient_t> inverse(m);
+	inverse[1] = 1;
+	// m = a * (m / a) + m % a
+	// Multipying with inverse(a) * inverse(m % a):
+	// 0 = inverse(m % a) * (m / a) + inverse(a)  (mod m)
+	for (coefficient_t a = 2; a < m; ++a) inverse[a] = m - (inverse[m % a] * (m / a)) % m;
+	return inverse;
+}
+
+#ifdef USE_COEFFICIENTS
+
+template <typename Index> struct entry {
+	Index index : 8 * sizeof(Index) - num_coefficient_bits;
+	coefficient_t coefficient : num_coefficient_bits;
+	entry(Index _index, coefficient_t _coefficient)
+	    : index(_index), coefficient(_coefficient) {}
+	entry(Index _index) : index(_index), coefficient(0) {}
+	entry() : index(0), coefficient(0) {}
+};
+
+static_assert(sizeof(entry<int64_t>) == sizeof(int64_t), "size of entry is not the same as index");
+static_assert(sizeof(entry<int32_t>) == sizeof(int32_t), "size of entry is not the same as index");
+
+template <typename Index> entry<Index> make_entry(Index i, coefficient_t c) {
+	return entry<Index>(i, c);
+}
+template <typename Index> Index get_index(const entry<Index>& e) { return e.index; }
+template <typename Index> index_t get_coefficient(const entry<Index>& e) { return e.coefficient; }
+template <typename Index> void set_coefficient(entry<Index>& e, const coefficient_t c) {
+	e.coefficient = c;
+}
+template <typename Index> const entry<Index>& get_entry(const entry<Index>& e) { return e; }
+
+template <typename Index>
+std::ostream& operator<<(std::ostream& stream, const entry<Index>& e) {
+	stream << get_index(e) << ":" << get_coefficient(e);
+	return stream;
+}
+
+#else
+
+template <typename Index> using entry = Index;
+template <typename Index, typename T = Index>
+using if_index_t = typename std::enable_if<std::is_integral<Index>::value, T>::type;
+
+template <typename Index> const if_index_t<Index> get_index(const Index& i) { return i; }
+template <typename Index> if_index_t<Index, index_t> get_coefficient(const Index& i) { return 1; }
+template <typename Index> if_index_t<Index> make_entry(Index _index, coefficient_t _value) {
+	return _index;
+}
+template <typename Index> if_index_t<Index, void> set_coefficient(Index& e, const coefficient_t c) {}
+template <typename Index> const if_index_t<Index>& get_entry(const Index& e) { return e; }
+
+#endif
+
+template <typename Index> using diameter_index = std::pair<value_t, Index>;
+template <typename Index> value_t get_diameter(const diameter_index<Index>& i) { return i.first; }
+template <typename Index> Index get_index(const diameter_index<Index>& i) { return i.second; }
+
+typedef std::pair<index_t, value_t> index_diameter_t;
+inline index_t get_index(const index_diameter_t& i) { return i.first; }
+inline value_t get_diameter(const index_diameter_t& i) { return i.second; }
+
+template <typename Index> struct diameter_entry : std::pair<value_t, entry<Index>> {
+	using std::pair<value_t, entry<Index>>::pair;
+	diameter_entry(value_t _diameter, Index _index, coefficient_t _coefficient)
+	    : diameter_entry(_diameter, make_entry(_index, _coefficient)) {}
+	diameter_entry(const diameter_index<Index>& _diameter_index, coefficient_t _coefficient)
+	    : diameter_entry(get_diameter(_diameter_index),
+	                     make_entry(get_index(_diameter_index), _coefficient)) {}
+	diameter_entry(const diameter_index<Index>& _diameter_index)
+	    : diameter_entry(get_diameter(_diameter_index),
+	                     make_entry(get_index(_diameter_index), 0)) {}
+	diameter_entry(const Index& _index) : diameter_entry(0, _index, 0) {}
+};
+
+template <typename Index> const entry<Index>& get_entry(const diameter_entry<Index>& p) {
+	return p.second;
+}
+template <typename Index> entry<Index>& get_entry(diameter_entry<Index>& p) { return p.second; }
+template <typename Index> const Index get_index(const diameter_entry<Index>& p) {
+	return get_index(get_entry(p));
+}
+template <typename Index> const coefficient_t get_coefficient(const diameter_entry<Index>& p) {
+	return get_coefficient(get_entry(p));
+}
+template <typename Index> const value_t& get_diameter(const diameter_entry<Index>& p) {
+	return p.first;
+}
+template <typename Index> void set_coefficient(diameter_entry<Index>& p, const coefficient_t c) {
+	set_coefficient(get_entry(p), c);
+}
+
+template <typename Entry> struct greater_diameter_or_smaller_index_comp {
+	bool operator()(const Entry& a, const Entry& b) {
+		return greater_diameter_or_smaller_index(a, b);
+	}
+};
+
+template <typename Entry> bool greater_diameter_or_smaller_index(const Entry& a, const Entry& b) {
+	return (get_diameter(a) > get_diameter(b)) ||
+	       ((get_diameter(a) == get_diameter(b)) && (get_index(a) < get_index(b)));
+}
+
+// Packed sort keys for `diameter_index`, whose unsigned order is the order of
+// `greater_diameter_or_smaller_index`: the complemented diameter bits in the
+// high word, followed by the index bits.
+
+inline uint64_t pack_sort_key(const diameter_index<int32_t>& x) {
+	return (uint64_t(~radix::ordered_bits(get_diameter(x))) << 32) |
+	       radix::ordered_bits(get_index(x));
+}
+
+inline void unpack_sort_key(const uint64_t key, diameter_index<int32_t>& x) {
+	x = {radix::float_from_ordered_bits(~uint32_t(key >> 32)),
+	     radix::int32_from_ordered_bits(uint32_t(key))};
+}
+
+inline radix::key96 pack_sort_key(const diameter_index<int64_t>& x) {
+	const uint64_t index = radix::ordered_bits(get_index(x));
+	return {(uint64_t(~radix::ordered_bits(get_diameter(x))) << 32) | (index >> 32),
+	        uint32_t(index)};
+}
+
+inline void unpack_sort_key(const radix::key96& key, diameter_index<int64_t>& x) {
+	x = {radix::float_from_ordered_bits(~uint32_t(key.hi >> 32)),
+	     radix::int64_from_ordered_bits((key.hi << 32) | key.lo)};
+}
+
+// Equivalent to sorting with `greater_diameter_or_smaller_index`, on up to
+// `num_threads` threads.
+template <typename Index>
+void sort_greater_diameter_or_smaller_index(std::vector<diameter_index<Index>>& v, unsigned num_threads = 1) {
+	RIPSERR_TRACE_ZONE("sort");
+	std::vector<decltype(pack_sort_key(diameter_index<Index>()))> keys(v.size());
+	for (size_t i = 0; i < v.size(); ++i) keys[i] = pack_sort_key(v[i]);
+	radix::sort(keys, num_threads);
+	for (size_t i = 0; i < v.size(); ++i) unpack_sort_key(keys[i], v[i]);
+}
+
+enum compressed_matrix_layout { LOWER_TRIANGULAR, UPPER_TRIANGULAR };
+
+template <compressed_matrix_layout Layout> struct compressed_distance_matrix {
+	std::vector<value_t> distances;
+	std::vector<value_t*> rows;
+	// ripserr: If set, the distances are read in place from this (read-only)
+	// file mapping instead of `distances` (which are otherwise empty only for
+	// matrices read in place from the caller's memory).
+	std::shared_ptr<const mapped_file> file;
+
+	compressed_distance_matrix(std::vector<value_t>&& _distances)
+	    : distances(std::move(_distances)), rows((1 + std::sqrt(1 + 8 * distances.size())) / 2) {
+		assert(distances.size() == size() * (size() - 1) / 2);
+		init_rows(distances.data());
+	}
+
+	// ripserr: The `num_distances` values at `values`, in the same layout as
+	// `distances`, read in place; they must outlive the matrix.
+	compressed_distance_matrix(const value_t* values, size_t num_distances)
+	    : rows((1 + std::sqrt(1 + 8 * double(num_distances))) / 2) {
+		assert(num_distances == size() * (size() - 1) / 2);
+		init_rows(const_cast<value_t*>(values));
+	}
+
+	// ripserr: The `num_distances` values of type `value_t` from byte `offset` of
+	// a mapped file, in the same layout as `distances`.
+	compressed_distance_matrix(std::shared_ptr<const mapped_file> _file, size_t offset,
+	                           size_t num_distances)
+	    : rows((1 + std::sqrt(1 + 8 * double(num_distances))) / 2), file(std::move(_file)) {
+		assert(num_distances == size() * (size() - 1) / 2);
+		init_rows(reinterpret_cast<value_t*>(file->data() + offset));
+	}
+
+	template <typename DistanceMatrix>
+	compressed_distance_matrix(const DistanceMatrix& mat)
+	    : distances(mat.size() * (mat.size() - 1) / 2), rows(mat.size()) {
+		init_rows(distances.data());
+
+		for (size_t i = 1; i < size(); ++i)
+			for (size_t j = 0; j < i; ++j) rows[i][j] = mat(i, j);
+	}
+
+	value_t operator()(const index_t i, const index_t j) const;
+	size_t size() const { return rows.size(); }
+	void init_rows(value_t* pointer);
+};
+
+typedef compressed_distance_matrix<LOWER_TRIANGULAR> compressed_lower_distance_matrix;
+typedef compressed_distance_matrix<UPPER_TRIANGULAR> compressed_upper_distance_matrix;
+
+template <> inline void compressed_lower_distance_matrix::init_rows(value_t* pointer) {
+	for (size_t i = 1; i < size(); ++i) {
+		rows[i] = pointer;
+		pointer += i;
+	}
+}
+
+template <> inline void compressed_upper_distance_matrix::init_rows(value_t* pointer) {
+	--pointer;
+	for (size_t i = 0; i < size() - 1; ++i) {
+		rows[i] = pointer;
+		pointer += size() - i - 2;
+	}
+}
+
+template <>
+inline value_t compressed_lower_distance_matrix::operator()(const index_t i, const index_t j) const {
+	return i == j ? 0 : i < j ? rows[j][i] : rows[i][j];
+}
+
+template <>
+inline value_t compressed_upper_distance_matrix::operator()(const index_t i, const index_t j) const {
+	return i == j ? 0 : i > j ? rows[j][i] : rows[i][j];
+}
+
+// Neighbor lists are stored in compressed sparse row layout: the neighbors of
+// vertex `i` occupy positions `offsets[i]` to `offsets[i + 1]` of the flat
+// index and diameter arrays, sorted by increasing neighbor index.
+struct sparse_distance_matrix {
+	std::vector<size_t> offsets;
+	std::vector<int32_t> neighbor_indices;
+	std::vector<value_t> neighbor_diameters;
+
+	index_t num_edges;
+
+	sparse_distance_matrix(std::vector<std::vector<index_diameter_t>>&& _neighbors,
+	                       index_t _num_edges)
+	    : offsets(_neighbors.size() + 1, 0), num_edges(_num_edges) {
+		for (size_t i = 0; i < _neighbors.size(); ++i)
+			offsets[i + 1] = offsets[i] + _neighbors[i].size();
+		neighbor_indices.reserve(offsets.back());
+		neighbor_diameters.reserve(offsets.back());
+		for (auto& neighbors : _neighbors) {
+			for (auto neighbor : neighbors) push_neighbor(get_index(neighbor), get_diameter(neighbor));
+			std::vector<index_diameter_t>().swap(neighbors);
+		}
+	}
+
+	// ripserr: The neighbor lists in compressed sparse row layout, as built
+	// directly from a point cloud (see metrics.h).
+	sparse_distance_matrix(std::vector<size_t>&& _offsets, std::vector<int32_t>&& _neighbor_indices,
+	                       std::vector<value_t>&& _neighbor_diameters)
+	    : offsets(std::move(_offsets)), neighbor_indices(std::move(_neighbor_indices)),
+	      neighbor_diameters(std::move(_neighbor_diameters)), num_edges(index_t(neighbor_indices.size() / 2)) {}
+
+	template <typename DistanceMatrix>
+	sparse_distance_matrix(const DistanceMatrix& mat, const value_t threshold)
+	    : offsets(mat.size() + 1, 0), num_edges(0) {
+		assert(mat.size() <= size_t(std::numeric_limits<int32_t>::max()));
+
+		for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+			for (size_t j = 0; j + 1 < offsets.size(); ++j)
+				if (i != j) {
+					auto d = mat(i, j);
+					if (d <= threshold) {
+						++num_edges;
+						push_neighbor(j, d);
+					}
+				}
+			offsets[i + 1] = neighbor_indices.size();
+		}
+	}
+
+	value_t operator()(const index_t i, const index_t j) const {
+		auto begin = neighbor_indices.begin() + offsets[i],
+		     end = neighbor_indices.begin() + offsets[i + 1];
+		auto neighbor = std::lower_bound(begin, end, j);
+		return (neighbor != end && *neighbor == j)
+		           ? neighbor_diameters[neighbor - neighbor_indices.begin()]
+		           : std::numeric_limits<value_t>::infinity();
+	}
+
+	size_t size() const { return offsets.size() - 1; }
+
+private:
+	void push_neighbor(const index_t j, const value_t d) {
+		neighbor_indices.push_back(int32_t(j));
+		neighbor_diameters.push_back(d);
+	}
+};
+
+// Neighbor list intersection kernels for the sparse coboundary enumerator.
+// `skip_greater(begin, it, j)` walks the sorted range [begin, it) backwards and
+// returns the position one past the last index not exceeding `j`, or `begin` if
+// there is none (i.e. `std::upper_bound(begin, it, j)`). Short gaps are scanned
+// linearly, using SSE2 or AVX2 where the CPU supports it; long gaps gallop.
+
+typedef const int32_t* (*skip_greater_t)(const int32_t*, const int32_t*, const int32_t);
+
+static const int linear_scan_length = 32;
+
+inline const int32_t* gallop_greater(const int32_t* begin, const int32_t* it, const int32_t j) {
+	size_t step = 1;
+	while (it != begin) {
+		const int32_t* probe = size_t(it - begin) > step ? it - step : begin;
+		if (*probe <= j) return std::upper_bound(probe + 1, it, j);
+		it = probe;
+		step <<= 1;
+	}
+	return begin;
+}
+
+inline const int32_t* skip_greater_scalar(const int32_t* begin, const int32_t* it, const int32_t j) {
+	for (int count = 0; it != begin; --it, ++count) {
+		if (it[-1] <= j) return it;
+		if (count == linear_scan_length) return gallop_greater(begin, it, j);
+	}
+	return it;
+}
+
+#ifdef RIPSER_X86_DISPATCH
+
+inline __attribute__((target("sse2"))) const int32_t*
+skip_greater_sse2(const int32_t* begin, const int32_t* it, const int32_t j) {
+	const __m128i key = _mm_set1_epi32(j);
+	for (int blocks = linear_scan_length / 4; it - begin >= 4; it -= 4) {
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it - 4));
+		int greater = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, key)));
+		if (greater != 0xf) return it - __builtin_popcount(greater);
+		if (--blocks == 0) return gallop_greater(begin, it - 4, j);
+	}
+	while (it != begin && it[-1] > j) --it;
+	return it;
+}
+
+inline __attribute__((target("avx2"))) const int32_t*
+skip_greater_avx2(const int32_t* begin, const int32_t* it, const int32_t j) {
+	const __m256i key = _mm256_set1_epi32(j);
+	for (int blocks = linear_scan_length / 8; it - begin >= 8; it -= 8) {
+		__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it - 8));
+		int greater = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(block, key)));
+		if (greater != 0xff) return it - __builtin_popcount(greater);
+		if (--blocks == 0) return gallop_greater(begin, it - 8, j);
+	}
+	while (it != begin && it[-1] > j) --it;
+	return it;
+}
+
+#endif
+
+inline skip_greater_t select_skip_greater() {
+#ifdef RIPSER_X86_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return skip_greater_avx2;
+	if (__builtin_cpu_supports("sse2")) return skip_greater_sse2;
+#endif
+	return skip_greater_scalar;
+}
+
+static const skip_greater_t skip_greater = select_skip_greater();
+
+// Element-wise minimum kernel `min_into(a, b, len)`, setting `a[i]` to the
+// smaller of `a[i]` and `b[i]`; used to maintain distances to a growing
+// spanning tree.
+
+typedef void (*min_into_t)(value_t*, const value_t*, const size_t);
+
+inline void min_into_scalar(value_t* a, const value_t* b, const size_t len) {
+	for (size_t i = 0; i < len; ++i) a[i] = std::min(a[i], b[i]);
+}
+
+#ifdef RIPSER_X86_DISPATCH
+
+inline __attribute__((target("sse"))) void min_into_sse(value_t* a, const value_t* b,
+                                                          const size_t len) {
+	size_t i = 0;
+	for (; i + 4 <= len; i += 4)
+		_mm_storeu_ps(a + i, _mm_min_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	min_into_scalar(a + i, b + i, len - i);
+}
+
+inline __attribute__((target("avx"))) void min_into_avx(value_t* a, const value_t* b,
+                                                         const size_t len) {
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8)
+		_mm256_storeu_ps(a + i, _mm256_min_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	min_into_scalar(a + i, b + i, len - i);
+}
+
+#endif
+
+inline min_into_t select_min_into() {
+#ifdef RIPSER_X86_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx")) return min_into_avx;
+	if (__builtin_cpu_supports("sse")) return min_into_sse;
+#endif
+	return min_into_scalar;
+}
+
+static const min_into_t min_into = select_min_into();
+
+struct euclidean_distance_matrix {
+	std::vector<std::vector<value_t>> points;
+
+	euclidean_distance_matrix(std::vector<std::vector<value_t>>&& _points)
+	    : points(std::move(_points)) {
+		for (auto p : points) { assert(p.size() == points.front().size()); }
+	}
+
+	value_t operator()(const index_t i, const index_t j) const {
+		assert(i < points.size());
+		assert(j < points.size());
+		return std::sqrt(std::inner_product(
+		    points[i].begin(), points[i].end(), points[j].begin(), value_t(), std::plus<value_t>(),
+		    [](value_t u, value_t v) { return (u - v) * (u - v); }));
+	}
+
+	size_t size() const { return points.size(); }
+};
+
+// ripserr: The number of points of the delay embedding of a time series of
+// `length` observations (see `delay_embedding_distances`), or 0 if it has none.
+inline index_t delay_embedding_size(index_t length, index_t data_dim, index_t dim_lag, index_t sample_lag) {
+	const index_t samples = (length + sample_lag - 1) / sample_lag;
+	return std::max(samples - dim_lag * (data_dim - 1), index_t(0));
+}
+
+// ripserr: The distances between the points of the delay embedding of a time
+// series of `length` observations of `channels` variables, stored by variable
+// (as an R matrix): the samples are every `sample_lag`-th observation, and each
+// point is the window of `data_dim` samples `dim_lag` apart. The window of
+// point `i` is that of point `i - dim_lag` shifted by one sample, so the squared
+// distance of points `i` and `j` is that of `i - dim_lag` and `j - dim_lag`
+// less their first term plus their last. These are kept in double precision
+// for the last `dim_lag` rows and summed afresh at the start of each chain of
+// updates, every 64 updates and after cancellation, which keeps the distances
+// as accurate as in single precision. Windows of at most 8 samples are summed
+// afresh, which is as fast.
+inline compressed_lower_distance_matrix delay_embedding_distances(const double* series, index_t length,
+                                                                  index_t channels, index_t data_dim,
+                                                                  index_t dim_lag, index_t sample_lag) {
+	RIPSERR_TRACE_ZONE("delay_embedding_distances");
+	const index_t n = delay_embedding_size(length, data_dim, dim_lag, sample_lag);
+	const index_t last = dim_lag * (data_dim - 1);
+	const double cancellation = std::ldexp(1.0, -20);
+
+	// the samples, by sample
+	const index_t samples = n + last;
+	std::vector<double> y(size_t(samples) * channels);
+	for (index_t a = 0; a < samples; ++a)
+		for (index_t c = 0; c < channels; ++c) y[size_t(a) * channels + c] = series[size_t(c) * length + size_t(a) * sample_lag];
+
+	// the squared distance between samples `a` and `b`
+	auto squared_difference = [&](index_t a, index_t b) {
+		const double* u = &y[size_t(a) * channels];
+		const double* v = &y[size_t(b) * channels];
+		double sum = 0;
+		for (index_t c = 0; c < channels; ++c) sum += (u[c] - v[c]) * (u[c] - v[c]);
+		return sum;
+	};
+	auto squared_distance = [&](index_t i, index_t j) {
+		double sum = 0;
+		for (index_t k = 0; k <= last; k += dim_lag) sum += squared_difference(i + k, j + k);
+		return sum;
+	};
+
+	// the squared distances of the last `dim_lag` rows and the largest of their
+	// chains since it was last summed afresh, by row modulo `dim_lag`
+	struct chain {
+		double sum, scale;
+	};
+	const bool updates = dim_lag < n && data_dim > 8;
+	std::vector<std::vector<chain>> recent(updates ? dim_lag : 0, std::vector<chain>(n));
+
+	std::vector<value_t> distances(size_t(n) * (n - 1) / 2);
+	value_t* row = distances.data();
+	for (index_t j = 1; j < n; row += j++) {
+		if (!updates) {
+			for (index_t i = 0; i < j; ++i) row[i] = value_t(std::sqrt(squared_distance(i, j)));
+			continue;
+		}
+		// downwards, so that the entries of row `j - dim_lag` are read before
+		// those of row `j` take their place; `i` is the `step`-th of its chain
+		chain* current = recent[j % dim_lag].data();
+		index_t step = (j - 1) / dim_lag, offset = (j - 1) % dim_lag;
+		for (index_t i = j - 1; i >= 0; --i) {
+			chain& c = current[i];
+			if (step % 64 != 0) {
+				const chain& p = current[i - dim_lag];
+				c.sum = p.sum - squared_difference(i - dim_lag, j - dim_lag) +
+				        squared_difference(i + last, j + last);
+				c.scale = std::max(p.scale, c.sum);
+				if (c.sum < c.scale * cancellation) c.sum = c.scale = squared_distance(i, j);
+			} else
+				c.sum = c.scale = squared_distance(i, j);
+			row[i] = value_t(std::sqrt(std::max(c.sum, 0.0)));
+			if (offset-- == 0) {
+				offset = dim_lag - 1;
+				--step;
+			}
+		}
+	}
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+class union_find {
+	std::vector<index_t> parent;
+	std::vector<uint8_t> rank;
+
+public:
+	union_find(const index_t n) : parent(n), rank(n, 0) {
+		for (index_t i = 0; i < n; ++i) parent[i] = i;
+	}
+
+	index_t find(index_t x) {
+		index_t y = x, z;
+		while ((z = parent[y]) != y) y = z;
+		while ((z = parent[x]) != y) {
+			parent[x] = y;
+			x = z;
+		}
+		return z;
+	}
+
+	void link(index_t x, index_t y) {
+		if ((x = find(x)) == (y = find(y))) return;
+		if (rank[x] > rank[y])
+			parent[y] = x;
+		else {
+			parent[x] = y;
+			if (rank[x] == rank[y]) ++rank[y];
+		}
+	}
+};
+
+template <typename T> T begin(std::pair<T, T>& p) { return p.first; }
+template <typename T> T end(std::pair<T, T>& p) { return p.second; }
+
+template <typename ValueType> class compressed_sparse_matrix {
+	std::vector<size_t> bounds;
+	std::vector<ValueType> entries;
+
+	typedef typename std::vector<ValueType>::iterator iterator;
+	typedef std::pair<iterator, iterator> iterator_pair;
+
+public:
+	size_t size() const { return bounds.size(); }
+
+	iterator_pair subrange(const index_t index) {
+		return {entries.begin() + (index == 0 ? 0 : bounds[index - 1]),
+		        entries.begin() + bounds[index]};
+	}
+
+	void append_column() { bounds.push_back(entries.size()); }
+
+	void push_back(const ValueType e) {
+		assert(0 < size());
+		entries.push_back(e);
+		++bounds.back();
+	}
+
+	// ripserq: The bytes held by the matrix.
+	size_t memory() const {
+		return bounds.capacity() * sizeof(size_t) + entries.capacity() * sizeof(ValueType);
+	}
+};
+
+template <typename Index, class Predicate>
+Index get_max(Index top, const Index bottom, const Predicate pred) {
+	if (!pred(top)) {
+		Index count = top - bottom;
+		while (count > 0) {
+			Index step = count >> 1, mid = top - step;
+			if (!pred(mid)) {
+				top = mid - 1;
+				count -= step + 1;
+			} else
+				count = step;
+		}
+	}
+	return top;
+}
+
+template <typename DistanceMatrix, typename Index> class simplex_coboundary_enumerator;
+
+template <typename DistanceMatrix, typename Index = index_t> class ripser {
+	// Within the engine, `index_t` is the (possibly narrowed) simplex index type.
+	typedef Index index_t;
+	typedef vr::entry<Index> entry_t;
+	typedef vr::diameter_index<Index> diameter_index_t;
+	typedef vr::diameter_entry<Index> diameter_entry_t;
+
+	template <typename, typename> friend class simplex_coboundary_enumerator;
+
+	const DistanceMatrix dist;
+	const index_t n, dim_max;
+	const value_t threshold;
+	const float ratio;
+	const coefficient_t modulus;
+	const binomial_coeff_table<Index> binomial_coeff;
+	const std::vector<coefficient_t> multiplicative_inverse;
+	mutable std::vector<diameter_entry_t> cofacet_entries;
+	mutable std::vector<index_t> vertices;
+
+	struct entry_hash {
+		std::size_t operator()(const entry_t& e) const { return hash<index_t>()(vr::get_index(e)); }
+	};
+
+	struct equal_index {
+		bool operator()(const entry_t& e, const entry_t& f) const {
+			return vr::get_index(e) == vr::get_index(f);
+		}
+	};
+
+	typedef hash_map<entry_t, size_t, entry_hash, equal_index> entry_hash_map;
+
+	// ripserq: The bytes held by the distances and by the simplices of the
+	// enclosing phases, and those held by the structures of the engine, as
+	// checked against `max_memory` (a hash map node holds its entry, a link, a
+	// bucket and allocation overhead).
+	size_t memory_retained = 0;
+	template <typename T> static size_t memory(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+	static size_t memory(const entry_hash_map& map) {
+		return map.size() * (sizeof(typename entry_hash_map::value_type) + 3 * sizeof(void*));
+	}
+	static size_t memory(const compressed_lower_distance_matrix& d) {
+		return memory(d.distances) + memory(d.rows);
+	}
+	static size_t memory(const sparse_distance_matrix& d) {
+		return memory(d.offsets) + memory(d.neighbor_indices) + memory(d.neighbor_diameters);
+	}
+
+	// ripserq: Stops the computation if it holds more than `max_memory` bytes.
+	void check_memory(const size_t bytes, const index_t dim) const {
+		if (bytes > max_memory)
+			ripserr::stop("the computation of dimension %d exceeds `max_memory` (%.4g MB); see `vr_estimate()`",
+			              int(dim), double(max_memory) / 1e6);
+	}
+
+public:
+  // ripserq: Accumulate pairs in an object to be returned to the user.
+  std::vector<std::vector<std::pair<value_t, value_t>>> persistence_pairs;
+  // ripserq: If set, the merges of dimension 0 are recorded as a dendrogram.
+  dendrogram* merges = nullptr;
+  // ripserq: Pairs are reported only from dimension `dim_min` on; lower
+  // dimensions are reduced only to clear its columns, or not at all if
+  // `clearing` is false.
+  index_t dim_min = 0;
+  bool clearing = true;
+  // ripserq: The threshold of each dimension, non-increasing from `threshold`;
+  // the homology in dimension `d` is that of the complex up to `thresholds[d]`.
+  std::vector<value_t> thresholds;
+  // ripserq: Pairs that persist less than this (or than `ratio`) are not stored.
+  value_t min_persistence = 0;
+  // ripserq: If positive, only the `top_k` most persistent pairs of each
+  // dimension are kept, in order of decreasing persistence, in the heap
+  // `top_pairs` until the dimension is finished.
+  size_t top_k = 0;
+  most_persistent<std::pair<value_t, value_t>> top_pairs;
+  // ripserq: If set, the timings and counters of each phase are recorded.
+  engine_stats* stats = nullptr;
+  // ripserq: The counters of the current phase.
+  phase_stats counts;
+  // ripserq: If positive, the computation stops with an error once the
+  // distances, simplices, columns, pivots and reduction matrix it holds exceed
+  // this many bytes, rather than running out of memory.
+  size_t max_memory = 0;
+  // ripserq: The threads on which large lists of columns and edges are sorted.
+  unsigned num_threads = 1;
+  
+	ripser(DistanceMatrix&& _dist, index_t _dim_max, value_t _threshold, float _ratio,
+	       coefficient_t _modulus)
+	    : dist(std::move(_dist)), n(dist.size()),
+	      dim_max(std::min(_dim_max, index_t(dist.size() - 2))), threshold(_threshold),
+	      ratio(_ratio), modulus(_modulus), binomial_coeff(n, dim_max + 2),
+	      multiplicative_inverse(multiplicative_inverse_vector(_modulus)),
+	      thresholds(dim_max + 1, _threshold) {}
+
+	index_t get_max_vertex(const index_t idx, const index_t k, const index_t n) const {
+		return get_max(n, k - 1, [&](index_t w) -> bool { return (binomial_coeff(w, k) <= idx); });
+	}
+
+	index_t get_edge_index(const index_t i, const index_t j) const {
+		return binomial_coeff(i, 2) + j;
+	}
+
+	template <typename OutputIterator>
+	OutputIterator get_simplex_vertices(index_t idx, const index_t dim, index_t n,
+	                                    OutputIterator out) const {
+		--n;
+		for (index_t k = dim + 1; k > 1; --k) {
+			n = get_max_vertex(idx, k, n);
+			*out++ = n;
+			idx -= binomial_coeff(n, k);
+		}
+		*out = idx;
+		return out;
+	}
+
+	value_t compute_diameter(const index_t index, const index_t dim) const {
+		value_t diam = -std::numeric_limits<value_t>::infinity();
+
+		vertices.resize(dim + 1);
+		get_simplex_vertices(index, dim, dist.size(), vertices.rbegin());
+
+		for (index_t i = 0; i <= dim; ++i)
+			for (index_t j = 0; j < i; ++j) {
+				diam = std::max(diam, dist(vertices[i], vertices[j]));
+			}
+		return diam;
+	}
+
+	class simplex_boundary_enumerator {
+	private:
+		index_t idx_below, idx_above, j, k;
+		diameter_entry_t simplex;
+		index_t dim;
+		const coefficient_t modulus;
+		const binomial_coeff_table<Index>& binomial_coeff;
+		const ripser& parent;
+
+	public:
+		simplex_boundary_enumerator(const diameter_entry_t _simplex, const index_t _dim,
+		                            const ripser& _parent)
+		    : idx_below(get_index(_simplex)), idx_above(0), j(_parent.n - 1), k(_dim),
+		      simplex(_simplex), modulus(_parent.modulus), binomial_coeff(_parent.binomial_coeff),
+		      parent(_parent) {}
+
+		simplex_boundary_enumerator(const index_t _dim, const ripser& _parent)
+		    : simplex_boundary_enumerator(-1, _dim, _parent) {}
+
+		void set_simplex(const diameter_entry_t _simplex, const index_t _dim) {
+			idx_below = get_index(_simplex);
+			idx_above = 0;
+			j = parent.n - 1;
+			k = _dim;
+			simplex = _simplex;
+			dim = _dim;
+		}
+
+		bool has_next() { return (k >= 0); }
+
+		diameter_entry_t next() {
+			j = parent.get_max_vertex(idx_below, k + 1, j);
+
+			index_t face_index = idx_above - binomial_coeff(j, k + 1) + idx_below;
+
+			value_t face_diameter = parent.compute_diameter(face_index, dim - 1);
+
+			coefficient_t face_coefficient =
+			    (k & 1 ? -1 + modulus : 1) * get_coefficient(simplex) % modulus;
+
+			idx_below -= binomial_coeff(j, k + 1);
+			idx_above += binomial_coeff(j, k);
+
+			--k;
+
+			return diameter_entry_t(face_diameter, face_index, face_coefficient);
+		}
+	};
+
+	diameter_entry_t get_zero_pivot_facet(const diameter_entry_t simplex, const index_t dim) {
+		// ripserq: Use of `static` variables induces an R end-of-program problem:
+		// https://github.com/Ripser/ripser/issues/55
+		simplex_boundary_enumerator facets(0, *this);
+		facets.set_simplex(simplex, dim);
+		while (facets.has_next()) {
+			diameter_entry_t facet = facets.next();
+			if (get_diameter(facet) == get_diameter(simplex)) return facet;
+		}
+		return diameter_entry_t(-1);
+	}
+
+	diameter_entry_t get_zero_pivot_cofacet(const diameter_entry_t simplex, const index_t dim) {
+	  // ripserq: Use of `static` variables induces an R end-of-program problem:
+	  // https://github.com/Ripser/ripser/issues/55
+		simplex_coboundary_enumerator<DistanceMatrix, Index> cofacets(*this);
+		cofacets.set_simplex(simplex, dim);
+		while (cofacets.has_next()) {
+			diameter_entry_t cofacet = cofacets.next();
+			if (get_diameter(cofacet) == get_diameter(simplex)) return cofacet;
+		}
+		return diameter_entry_t(-1);
+	}
+
+	diameter_entry_t get_zero_apparent_facet(const diameter_entry_t simplex, const index_t dim) {
+		diameter_entry_t facet = get_zero_pivot_facet(simplex, dim);
+		return ((get_index(facet) != -1) &&
+		        (get_index(get_zero_pivot_cofacet(facet, dim - 1)) == get_index(simplex)))
+		           ? facet
+		           : diameter_entry_t(-1);
+	}
+
+	diameter_entry_t get_zero_apparent_cofacet(const diameter_entry_t simplex, const index_t dim) {
+		diameter_entry_t cofacet = get_zero_pivot_cofacet(simplex, dim);
+		return ((get_index(cofacet) != -1) &&
+		        (get_index(get_zero_pivot_facet(cofacet, dim + 1)) == get_index(simplex)))
+		           ? cofacet
+		           : diameter_entry_t(-1);
+	}
+
+	bool is_in_zero_apparent_pair(const diameter_entry_t simplex, const index_t dim) {
+		return (get_index(get_zero_apparent_cofacet(simplex, dim)) != -1) ||
+		       (get_index(get_zero_apparent_facet(simplex, dim)) != -1);
+	}
+
+	void assemble_columns_to_reduce(std::vector<diameter_index_t>& simplices,
+	                                std::vector<diameter_index_t>& columns_to_reduce,
+	                                entry_hash_map& pivot_column_index, index_t dim) {
+		// ripserq
+		RIPSERR_TRACE_ZONE("assemble_columns_to_reduce", dim);
+		phase_timer timer(stats, counts, "assemble", dim);
+
+#ifdef INDICATE_PROGRESS
+	  // ripserq
+	  ripserr::err << clear_line << "assembling columns" << std::flush;
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + time_step;
+#endif
+
+		columns_to_reduce.clear();
+		std::vector<diameter_index_t> next_simplices;
+
+		simplex_coboundary_enumerator<DistanceMatrix, Index> cofacets(*this);
+
+		for (diameter_index_t& simplex : simplices) {
+			// ripserq
+			if (max_memory)
+				check_memory(memory(dist) + memory(simplices) + memory(next_simplices) +
+				                 memory(columns_to_reduce) + memory(pivot_column_index),
+				             dim);
+			cofacets.set_simplex(diameter_entry_t(simplex, 1), dim - 1);
+
+			while (cofacets.has_next(false)) {
+#ifdef INDICATE_PROGRESS
+				if (std::chrono::steady_clock::now() > next) {
+				  // ripserq
+				  ripserr::err << clear_line << "assembling " << next_simplices.size()
+					          << " columns (processing " << std::distance(&simplices[0], &simplex)
+					          << "/" << simplices.size() << " simplices)" << std::flush;
+					next = std::chrono::steady_clock::now() + time_step;
+				}
+#endif
+				auto cofacet = cofacets.next();
+				if (get_diameter(cofacet) <= thresholds[dim]) {
+					if (dim < dim_max && get_diameter(cofacet) <= thresholds[dim + 1])
+						next_simplices.push_back({get_diameter(cofacet), get_index(cofacet)});
+					// ripserq: Count the columns skipped for lying in apparent pairs.
+					if (is_in_zero_apparent_pair(cofacet, dim))
+						++counts.apparent_pairs;
+					else if (pivot_column_index.find(get_entry(cofacet)) == pivot_column_index.end())
+						columns_to_reduce.push_back({get_diameter(cofacet), get_index(cofacet)});
+				}
+			}
+		}
+
+		if (dim < dim_max) simplices.swap(next_simplices);
+
+#ifdef INDICATE_PROGRESS
+		// ripserq
+		ripserr::err << clear_line << "sorting " << columns_to_reduce.size() << " columns"
+		          << std::flush;
+#endif
+
+		sort_greater_diameter_or_smaller_index(columns_to_reduce, num_threads);
+		// ripserq
+		counts.columns = columns_to_reduce.size();
+#ifdef INDICATE_PROGRESS
+		// ripserq
+		ripserr::err << clear_line << std::flush;
+#endif
+	}
+
+	// ripserq: Stores a pair unless it lies too close to the diagonal, in either
+	// absolute (`min_persistence`) or relative (`ratio`) terms.
+	void add_persistence_pair(const index_t dim, const value_t birth, const value_t death) {
+		if (!(death > birth * ratio && death - birth >= min_persistence)) return;
+		if (top_k > 0)
+			push_most_persistent(top_pairs, {birth, death}, top_k, persistence);
+		else
+			persistence_pairs[dim].emplace_back(birth, death);
+	}
+
+	// ripserq: Stores the kept pairs of a finished dimension in order.
+	void finish_persistence_pairs(const index_t dim) {
+		if (top_k > 0 && size_t(dim) < persistence_pairs.size())
+			append_most_persistent(top_pairs, persistence_pairs[dim], persistence);
+	}
+
+	static value_t persistence(const std::pair<value_t, value_t>& pair) {
+		return pair.second - pair.first;
+	}
+
+	// ripserq: Replaces the (dim - 1)-simplices by their cofacets within the
+	// threshold, without assembling them as columns.
+	void enumerate_cofacets(std::vector<diameter_index_t>& simplices, index_t dim) {
+		RIPSERR_TRACE_ZONE("enumerate_cofacets", dim);
+		phase_timer timer(stats, counts, "enumerate", dim);
+		std::vector<diameter_index_t> next_simplices;
+		simplex_coboundary_enumerator<DistanceMatrix, Index> cofacets(*this);
+		for (diameter_index_t& simplex : simplices) {
+			// ripserq
+			if (max_memory) check_memory(memory(dist) + memory(simplices) + memory(next_simplices), dim);
+			cofacets.set_simplex(diameter_entry_t(simplex, 1), dim - 1);
+			while (cofacets.has_next(false)) {
+				auto cofacet = cofacets.next();
+				if (get_diameter(cofacet) <= thresholds[dim])
+					next_simplices.push_back({get_diameter(cofacet), get_index(cofacet)});
+			}
+		}
+		simplices.swap(next_simplices);
+		counts.columns = simplices.size();
+	}
+
+	void compute_dim_0_pairs(std::vector<diameter_index_t>& edges,
+	                         std::vector<diameter_index_t>& columns_to_reduce) {
+		// ripserq
+		RIPSERR_TRACE_ZONE("compute_dim_0_pairs", 0);
+#ifdef PRINT_PERSISTENCE_PAIRS
+		// ripserq
+		ripserr::out << "persistence intervals in dim 0:" << std::endl;
+#endif
+
+		union_find dset(n);
+
+		// ripserq
+		edges = get_sorted_edges();
+		phase_timer timer(stats, counts, "union_find", 0);
+		counts.columns = edges.size();
+		// ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+		persistence_pairs.resize(dim_max + 1);
+#endif
+		std::vector<index_t> vertices_of_edge(2);
+		for (auto e : edges) {
+			get_simplex_vertices(get_index(e), 1, n, vertices_of_edge.rbegin());
+			index_t u = dset.find(vertices_of_edge[0]), v = dset.find(vertices_of_edge[1]);
+
+			if (u != v) {
+#ifdef PRINT_PERSISTENCE_PAIRS
+				if (get_diameter(e) != 0)
+				  // ripserq
+				  ripserr::out << " [0," << get_diameter(e) << ")" << std::endl;
+#endif
+				// ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+				if (dim_min == 0) add_persistence_pair(0, 0.0, get_diameter(e));
+#endif
+				dset.link(u, v);
+				if (merges) merges->merge(u, v, dset.find(u), get_diameter(e));
+			} else if ((dim_max > 0) && get_diameter(e) <= thresholds[1]) {
+				// ripserq: Count the columns skipped for lying in apparent pairs.
+				if (get_index(get_zero_apparent_cofacet(e, 1)) == -1)
+					columns_to_reduce.push_back(e);
+				else
+					++counts.apparent_pairs;
+			}
+		}
+		if (merges) merges->finish([&](index_t i) { return dset.find(i); });
+		if (dim_max > 0) std::reverse(columns_to_reduce.begin(), columns_to_reduce.end());
+		// ripserq
+		if (max_memory) check_memory(memory(dist) + memory(edges) + memory(columns_to_reduce), 0);
+
+#ifdef PRINT_PERSISTENCE_PAIRS
+		for (index_t i = 0; i < n; ++i)
+		  // ripserq
+		  if (dset.find(i) == i) ripserr::out << " [0, )" << std::endl;
+#endif
+		  // ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+    for (index_t i = 0; i < n && dim_min == 0; ++i)
+      if (dset.find(i) == i) add_persistence_pair(0, 0.0, std::numeric_limits<value_t>::infinity());
+    finish_persistence_pairs(0);
+#endif
+	}
+
+	template <typename Column> diameter_entry_t pop_pivot(Column& column) {
+		diameter_entry_t pivot(-1);
+#ifdef USE_COEFFICIENTS
+		while (!column.empty()) {
+			if (get_coefficient(pivot) == 0)
+				pivot = column.top();
+			else if (get_index(column.top()) != get_index(pivot))
+				return pivot;
+			else
+				set_coefficient(pivot,
+				                (get_coefficient(pivot) + get_coefficient(column.top())) % modulus);
+			column.pop();
+		}
+		return (get_coefficient(pivot) == 0) ? -1 : pivot;
+#else
+		while (!column.empty()) {
+			pivot = column.top();
+			column.pop();
+			if (column.empty() || get_index(column.top()) != get_index(pivot)) return pivot;
+			column.pop();
+		}
+		return -1;
+#endif
+	}
+
+	template <typename Column> diameter_entry_t get_pivot(Column& column) {
+		diameter_entry_t result = pop_pivot(column);
+		if (get_index(result) != -1) {
+			column.push(result);
+			// ripserq
+			++counts.heap_pushes;
+		}
+		return result;
+	}
+
+	template <typename Column>
+	diameter_entry_t init_coboundary_and_get_pivot(const diameter_entry_t simplex,
+	                                               Column& working_coboundary, const index_t& dim,
+	                                               entry_hash_map& pivot_column_index) {
+	  // ripserq: Use of `static` variables induces an R end-of-program problem:
+	  // https://github.com/Ripser/ripser/issues/55
+	  simplex_coboundary_enumerator<DistanceMatrix, Index> cofacets(*this);
+		bool check_for_emergent_pair = true;
+		cofacet_entries.clear();
+		cofacets.set_simplex(simplex, dim);
+		while (cofacets.has_next()) {
+			diameter_entry_t cofacet = cofacets.next();
+			if (get_diameter(cofacet) <= thresholds[dim]) {
+				cofacet_entries.push_back(cofacet);
+				if (check_for_emergent_pair && (get_diameter(simplex) == get_diameter(cofacet))) {
+					if ((pivot_column_index.find(get_entry(cofacet)) == pivot_column_index.end()) &&
+					    (get_index(get_zero_apparent_facet(cofacet, dim + 1)) == -1)) {
+						// ripserq
+						++counts.emergent_pairs;
+						return cofacet;
+					}
+					check_for_emergent_pair = false;
+				}
+			}
+		}
+		for (auto cofacet : cofacet_entries) working_coboundary.push(cofacet);
+		// ripserq
+		counts.heap_pushes += cofacet_entries.size();
+		return get_pivot(working_coboundary);
+	}
+
+	template <typename Column>
+	void add_simplex_coboundary(const diameter_entry_t simplex, const index_t& dim,
+	                            Column& working_reduction_column, Column& working_coboundary) {
+	  // ripserq: Use of `static` variables induces an R end-of-program problem:
+	  // https://github.com/Ripser/ripser/issues/55
+	  simplex_coboundary_enumerator<DistanceMatrix, Index> cofacets(*this);
+		working_reduction_column.push(simplex);
+		cofacets.set_simplex(simplex, dim);
+		// ripserq
+		size_t pushes = 1;
+		while (cofacets.has_next()) {
+			diameter_entry_t cofacet = cofacets.next();
+			if (get_diameter(cofacet) <= thresholds[dim]) {
+				working_coboundary.push(cofacet);
+				++pushes;
+			}
+		}
+		counts.heap_pushes += pushes;
+	}
+
+	template <typename Column>
+	void add_coboundary(compressed_sparse_matrix<diameter_entry_t>& reduction_matrix,
+	                    const std::vector<diameter_index_t>& columns_to_reduce,
+	                    const size_t index_column_to_add, const coefficient_t factor,
+	                    const size_t& dim, Column& working_reduction_column,
+	                    Column& working_coboundary) {
+		diameter_entry_t column_to_add(columns_to_reduce[index_column_to_add], factor);
+		add_simplex_coboundary(column_to_add, dim, working_reduction_column, working_coboundary);
+
+		for (diameter_entry_t simplex : reduction_matrix.subrange(index_column_to_add)) {
+			set_coefficient(simplex, get_coefficient(simplex) * factor % modulus);
+			add_simplex_coboundary(simplex, dim, working_reduction_column, working_coboundary);
+		}
+	}
+
+	void compute_pairs(const std::vector<diameter_index_t>& columns_to_reduce,
+	                   entry_hash_map& pivot_column_index, const index_t dim) {
+
+#ifdef PRINT_PERSISTENCE_PAIRS
+	  // ripserq
+	  ripserr::out << "persistence intervals in dim " << dim << ":" << std::endl;
+#endif
+	  // ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+	  persistence_pairs.resize(std::max(persistence_pairs.size(), static_cast<size_t>(dim + 1)));
+#endif
+	  // ripserq: Dimensions below `dim_min` are reduced only for their pivots. A
+	  // column that reduces to zero is an essential class only if it was not
+	  // cleared, which can't be told when the columns were not cleared.
+	  const bool report = dim >= dim_min;
+	  const bool report_essential = report && (clearing || dim > dim_min || dim <= 1);
+
+	  // ripserq
+	  RIPSERR_TRACE_ZONE("compute_pairs", dim);
+	  RIPSERR_TRACE_BATCHES(batches, "columns", dim, 4096);
+	  phase_timer timer(stats, counts, "reduce", dim);
+	  counts.columns = columns_to_reduce.size();
+
+		compressed_sparse_matrix<diameter_entry_t> reduction_matrix;
+		// ripserq: The memory held, with `scratch` entries in the working columns.
+		auto check_column_memory = [&](const size_t scratch) {
+			if (max_memory)
+				check_memory(memory_retained + memory(columns_to_reduce) + memory(pivot_column_index) +
+				                 reduction_matrix.memory() + scratch * sizeof(diameter_entry_t),
+				             dim);
+		};
+		
+#ifdef INDICATE_PROGRESS
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + time_step;
+#endif
+		for (size_t index_column_to_reduce = 0; index_column_to_reduce < columns_to_reduce.size();
+		     ++index_column_to_reduce) {
+			// ripserq
+			RIPSERR_TRACE_NEXT_BATCH(batches, index_column_to_reduce);
+			check_column_memory(0);
+
+			diameter_entry_t column_to_reduce(columns_to_reduce[index_column_to_reduce], 1);
+			value_t diameter = get_diameter(column_to_reduce);
+
+			reduction_matrix.append_column();
+
+			std::priority_queue<diameter_entry_t, std::vector<diameter_entry_t>,
+			                    greater_diameter_or_smaller_index_comp<diameter_entry_t>>
+			    working_reduction_column, working_coboundary;
+
+			diameter_entry_t e, pivot = init_coboundary_and_get_pivot(
+			                        column_to_reduce, working_coboundary, dim, pivot_column_index);
+
+			while (true) {
+#ifdef INDICATE_PROGRESS
+				if (std::chrono::steady_clock::now() > next) {
+				  // ripserq
+					ripserr::err << clear_line << "reducing column " << index_column_to_reduce + 1
+					          << "/" << columns_to_reduce.size() << " (diameter " << diameter << ")"
+					          << std::flush;
+					next = std::chrono::steady_clock::now() + time_step;
+				}
+#endif
+				if (get_index(pivot) != -1) {
+					auto pair = pivot_column_index.find(get_entry(pivot));
+					if (pair != pivot_column_index.end()) {
+						entry_t other_pivot = pair->first;
+						index_t index_column_to_add = pair->second;
+						coefficient_t factor =
+						    modulus - get_coefficient(pivot) *
+						                  multiplicative_inverse[get_coefficient(other_pivot)] %
+						                  modulus;
+
+						add_coboundary(reduction_matrix, columns_to_reduce, index_column_to_add,
+						               factor, dim, working_reduction_column, working_coboundary);
+						// ripserq
+						++counts.additions;
+						counts.scratch(working_reduction_column.size() + working_coboundary.size());
+						check_column_memory(working_reduction_column.size() + working_coboundary.size());
+
+						pivot = get_pivot(working_coboundary);
+					} else if (get_index(e = get_zero_apparent_facet(pivot, dim + 1)) != -1) {
+						set_coefficient(e, modulus - get_coefficient(e));
+
+						add_simplex_coboundary(e, dim, working_reduction_column, working_coboundary);
+						// ripserq
+						++counts.additions;
+						counts.scratch(working_reduction_column.size() + working_coboundary.size());
+						check_column_memory(working_reduction_column.size() + working_coboundary.size());
+
+						pivot = get_pivot(working_coboundary);
+					} else {
+#ifdef PRINT_PERSISTENCE_PAIRS
+						value_t death = get_diameter(pivot);
+						if (death > diameter * ratio) {
+#ifdef INDICATE_PROGRESS
+						  // ripserq
+							ripserr::err << clear_line << std::flush;
+#endif
+						  // ripserq
+						  ripserr::out << " [" << diameter << "," << death << ")" << std::endl;
+						}
+#endif
+						// ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+						if (report) add_persistence_pair(dim, diameter, get_diameter(pivot));
+#endif
+						pivot_column_index.insert({get_entry(pivot), index_column_to_reduce});
+
+						while (true) {
+							diameter_entry_t e = pop_pivot(working_reduction_column);
+							if (get_index(e) == -1) break;
+							assert(get_coefficient(e) > 0);
+							reduction_matrix.push_back(e);
+						}
+						break;
+					}
+				} else {
+#ifdef PRINT_PERSISTENCE_PAIRS
+#ifdef INDICATE_PROGRESS
+				  // ripserq
+					ripserr::err << clear_line << std::flush;
+#endif
+				  // ripserq
+				  ripserr::out << " [" << diameter << ", )" << std::endl;
+#endif
+				  // ripserq: Accumulate pairs in an object to be returned to the user.
+#ifdef COLLECT_PERSISTENCE_PAIRS
+				  if (report_essential)
+				    add_persistence_pair(dim, diameter, std::numeric_limits<value_t>::infinity());
+#endif
+					break;
+				}
+			}
+		}
+#ifdef COLLECT_PERSISTENCE_PAIRS
+		finish_persistence_pairs(dim);
+#endif
+#ifdef INDICATE_PROGRESS
+		// ripserq
+		ripserr::err << clear_line << std::flush;
+#endif
+	}
+
+	bool compute_dim_0_pairs_mst(const compressed_lower_distance_matrix& dist);
+	bool compute_dim_0_pairs_mst(const sparse_distance_matrix& /*dist*/) { return false; }
+
+	std::vector<diameter_index_t> get_edges() { return get_edges(dist); }
+
+	// ripserq: The edges within the threshold in order of increasing diameter
+	// (and decreasing index).
+	std::vector<diameter_index_t> get_sorted_edges() {
+		RIPSERR_TRACE_ZONE("get_edges", 1);
+		phase_timer timer(stats, counts, "edges", 1);
+		std::vector<diameter_index_t> edges = get_edges();
+		if (max_memory) check_memory(memory(dist) + memory(edges), 0);
+		sort_greater_diameter_or_smaller_index(edges, num_threads);
+		std::reverse(edges.begin(), edges.end());
+		counts.columns = edges.size();
+		return edges;
+	}
+	std::vector<diameter_index_t> get_edges(const compressed_lower_distance_matrix&);
+	std::vector<diameter_index_t> get_edges(const sparse_distance_matrix&);
+
+	// ripserq: Accumulate pairs in an object to be returned to the user.
+	std::vector<std::vector<std::pair<value_t, value_t>>> compute_barcodes() {
+		std::vector<diameter_index_t> simplices, columns_to_reduce;
+		// ripserq
+		RIPSERR_TRACE_ZONE("compute_barcodes");
+
+		// ripserq: No dimension is reported.
+		if (dim_min > dim_max) return persistence_pairs;
+		// ripserq: When only dimension 0 is requested, avoid the edge list if possible.
+		if (dim_max == 0 && compute_dim_0_pairs_mst(dist)) return persistence_pairs;
+
+		// ripserq: Without clearing, enumerate the columns of dimension `dim_min`
+		// directly. Clearing them needs the pivots of the dimension below, which are
+		// cheapest to obtain by the usual cascade of cleared reductions (whose pairs
+		// are not stored). Dimension 1 is always cleared, since the union-find pass
+		// costs no more than enumerating the edges (and records any dendrogram).
+		index_t dim_start = (clearing || merges) ? 1 : dim_min;
+		if (dim_start <= 1) {
+			compute_dim_0_pairs(simplices, columns_to_reduce);
+			dim_start = 1;
+		} else {
+			{
+				// ripserq
+				RIPSERR_TRACE_ZONE("get_edges", 1);
+				phase_timer timer(stats, counts, "edges", 1);
+				simplices = get_edges();
+				counts.columns = simplices.size();
+			}
+			for (index_t dim = 2; dim < dim_start; ++dim) enumerate_cofacets(simplices, dim);
+			entry_hash_map no_pivots;
+			assemble_columns_to_reduce(simplices, columns_to_reduce, no_pivots, dim_start);
+		}
+
+		for (index_t dim = dim_start; dim <= dim_max; ++dim) {
+			entry_hash_map pivot_column_index;
+			pivot_column_index.reserve(columns_to_reduce.size());
+			// ripserq
+			memory_retained = memory(dist) + memory(simplices);
+
+			compute_pairs(columns_to_reduce, pivot_column_index, dim);
+
+			if (dim < dim_max)
+				assemble_columns_to_reduce(simplices, columns_to_reduce, pivot_column_index,
+				                           dim + 1);
+		}
+		
+		// ripserq: Accumulate pairs in an object to be returned to the user.
+		return persistence_pairs;
+	}
+};
+
+template <typename Index>
+class simplex_coboundary_enumerator<compressed_lower_distance_matrix, Index> {
+	typedef Index index_t;
+	typedef vr::diameter_entry<Index> diameter_entry_t;
+	typedef ripser<compressed_lower_distance_matrix, Index> ripser_t;
+
+	index_t idx_below, idx_above, j, k;
+	std::vector<index_t> vertices;
+	diameter_entry_t simplex;
+	const coefficient_t modulus;
+	const compressed_lower_distance_matrix& dist;
+	const binomial_coeff_table<Index>& binomial_coeff;
+	const ripser_t& parent;
+
+public:
+	simplex_coboundary_enumerator(const diameter_entry_t _simplex, const index_t _dim,
+	                              const ripser_t& _parent)
+	    : modulus(_parent.modulus), dist(_parent.dist),
+	      binomial_coeff(_parent.binomial_coeff), parent(_parent) {
+		if (get_index(_simplex) != -1)
+			parent.get_simplex_vertices(get_index(_simplex), _dim, parent.n, vertices.rbegin());
+	}
+
+	simplex_coboundary_enumerator(const ripser_t& _parent) : modulus(_parent.modulus), dist(_parent.dist),
+	binomial_coeff(_parent.binomial_coeff), parent(_parent) {}
+
+	void set_simplex(const diameter_entry_t _simplex, const index_t _dim) {
+		idx_below = get_index(_simplex);
+		idx_above = 0;
+		j = parent.n - 1;
+		k = _dim + 1;
+		simplex = _simplex;
+		vertices.resize(_dim + 1);
+		parent.get_simplex_vertices(get_index(_simplex), _dim, parent.n, vertices.rbegin());
+	}
+
+	bool has_next(bool all_cofacets = true) {
+		return (j >= k && (all_cofacets || binomial_coeff(j, k) > idx_below));
+	}
+
+	diameter_entry_t next() {
+		while ((binomial_coeff(j, k) <= idx_below)) {
+			idx_below -= binomial_coeff(j, k);
+			idx_above += binomial_coeff(j, k + 1);
+			--j;
+			--k;
+			assert(k != -1);
+		}
+		value_t cofacet_diameter = get_diameter(simplex);
+		for (index_t i : vertices) cofacet_diameter = std::max(cofacet_diameter, dist(j, i));
+		index_t cofacet_index = idx_above + binomial_coeff(j--, k + 1) + idx_below;
+		coefficient_t cofacet_coefficient =
+		    (k & 1 ? modulus - 1 : 1) * get_coefficient(simplex) % modulus;
+		return diameter_entry_t(cofacet_diameter, cofacet_index, cofacet_coefficient);
+	}
+};
+
+template <typename Index> class simplex_coboundary_enumerator<sparse_distance_matrix, Index> {
+	typedef Index index_t;
+	typedef vr::diameter_entry<Index> diameter_entry_t;
+	typedef ripser<sparse_distance_matrix, Index> ripser_t;
+
+	index_t idx_below, idx_above, k;
+	std::vector<index_t> vertices;
+	diameter_entry_t simplex;
+	const coefficient_t modulus;
+	const sparse_distance_matrix& dist;
+	const binomial_coeff_table<Index>& binomial_coeff;
+	// Positions one past the next neighbor to visit (neighbor lists are walked
+	// backwards, from the largest neighbor index down) and the row starts.
+	std::vector<size_t> neighbor_it;
+	std::vector<size_t> neighbor_end;
+	index_diameter_t neighbor;
+	const ripser_t& parent;
+
+public:
+	simplex_coboundary_enumerator(const diameter_entry_t _simplex, const index_t _dim,
+	                              const ripser_t& _parent)
+	    : modulus(_parent.modulus), dist(_parent.dist),
+	      binomial_coeff(_parent.binomial_coeff), parent(_parent) {
+		if (get_index(_simplex) != -1) set_simplex(_simplex, _dim);
+	}
+
+	simplex_coboundary_enumerator(const ripser_t& _parent)
+	    : modulus(_parent.modulus), dist(_parent.dist),
+	binomial_coeff(_parent.binomial_coeff), parent(_parent) {}
+
+	void set_simplex(const diameter_entry_t _simplex, const index_t _dim) {
+		idx_below = get_index(_simplex);
+		idx_above = 0;
+		k = _dim + 1;
+		simplex = _simplex;
+		vertices.resize(_dim + 1);
+		parent.get_simplex_vertices(idx_below, _dim, parent.n, vertices.rbegin());
+
+		neighbor_it.resize(_dim + 1);
+		neighbor_end.resize(_dim + 1);
+		for (index_t i = 0; i <= _dim; ++i) {
+			auto v = vertices[i];
+			neighbor_it[i] = dist.offsets[v + 1];
+			neighbor_end[i] = dist.offsets[v];
+		}
+	}
+
+	bool has_next(bool all_cofacets = true) {
+		const int32_t* indices = dist.neighbor_indices.data();
+		const value_t* diameters = dist.neighbor_diameters.data();
+		size_t &it0 = neighbor_it[0], end0 = neighbor_end[0];
+		while (it0 != end0) {
+			neighbor = {indices[it0 - 1], diameters[it0 - 1]};
+			for (size_t idx = 1; idx < neighbor_it.size(); ++idx) {
+				size_t &it = neighbor_it[idx], end = neighbor_end[idx];
+				it = skip_greater(indices + end, indices + it, int32_t(get_index(neighbor))) - indices;
+				if (it == end) return false;
+				if (indices[it - 1] != get_index(neighbor)) {
+					// leapfrog: no common neighbor lies above the one just found
+					it0 = skip_greater(indices + end0, indices + it0, indices[it - 1]) - indices;
+					goto continue_outer;
+				} else
+					neighbor.second = std::max(get_diameter(neighbor), diameters[it - 1]);
+			}
+			while (k > 0 && vertices[k - 1] > get_index(neighbor)) {
+				if (!all_cofacets) return false;
+				idx_below -= binomial_coeff(vertices[k - 1], k);
+				idx_above += binomial_coeff(vertices[k - 1], k + 1);
+				--k;
+			}
+			return true;
+		continue_outer:;
+		}
+		return false;
+	}
+
+	diameter_entry_t next() {
+		--neighbor_it[0];
+		value_t cofacet_diameter = std::max(get_diameter(simplex), get_diameter(neighbor));
+		index_t cofacet_index = idx_above + binomial_coeff(get_index(neighbor), k + 1) + idx_below;
+		coefficient_t cofacet_coefficient =
+		    (k & 1 ? modulus - 1 : 1) * get_coefficient(simplex) % modulus;
+		return diameter_entry_t(cofacet_diameter, cofacet_index, cofacet_coefficient);
+	}
+};
+
+// ripserq: The dimension 0 pairs of a dense distance matrix are determined by the
+// edges of a minimum spanning tree that do not exceed the threshold. Prim's
+// algorithm finds them in O(n^2) time with O(n) additional memory, instead of
+// materializing and sorting all edges. The pairs are reported in the same order
+// as by `compute_dim_0_pairs`.
+template <typename DistanceMatrix, typename Index>
+bool ripser<DistanceMatrix, Index>::compute_dim_0_pairs_mst(
+    const compressed_lower_distance_matrix& dist) {
+#ifdef PRINT_PERSISTENCE_PAIRS
+	// ripserq
+	ripserr::out << "persistence intervals in dim 0:" << std::endl;
+#endif
+	RIPSERR_TRACE_ZONE("compute_dim_0_pairs_mst", 0);
+	phase_timer timer(stats, counts, "mst", 0);
+	counts.columns = n;
+
+	// Distance from each vertex to the tree; vertices in the tree are marked by
+	// -infinity, which taking minima preserves.
+	const value_t in_tree = -std::numeric_limits<value_t>::infinity();
+	std::vector<value_t> distance_to_tree(n, std::numeric_limits<value_t>::infinity());
+	std::vector<value_t> deaths;
+	std::vector<std::pair<value_t, std::pair<index_t, index_t>>> tree_edges;
+	index_t num_components = n;
+
+	for (index_t u = 0, num_vertices = 1; num_vertices < n; ++num_vertices) {
+		distance_to_tree[u] = in_tree;
+		min_into(distance_to_tree.data(), dist.rows[u], u);
+		for (index_t j = u + 1; j < n; ++j)
+			distance_to_tree[j] = std::min(distance_to_tree[j], dist.rows[j][u]);
+
+		index_t v = -1;
+		for (index_t j = 0; j < n; ++j)
+			if (distance_to_tree[j] != in_tree &&
+			    (v == -1 || distance_to_tree[j] < distance_to_tree[v]))
+				v = j;
+
+		const value_t diameter = distance_to_tree[v];
+		if (diameter <= threshold) {
+			--num_components;
+			if (diameter != 0) deaths.push_back(diameter);
+			// the tree vertex that `v` is attached to is one at distance `diameter`
+			if (merges)
+				for (index_t w = 0; w < n; ++w)
+					if (distance_to_tree[w] == in_tree && dist(v, w) == diameter) {
+						tree_edges.push_back({diameter, {v, w}});
+						break;
+					}
+		}
+		u = v;
+	}
+	std::sort(deaths.begin(), deaths.end());
+
+	if (merges) {
+		std::sort(tree_edges.begin(), tree_edges.end());
+		union_find dset(n);
+		for (const auto& e : tree_edges) {
+			const index_t u = dset.find(e.second.first), v = dset.find(e.second.second);
+			dset.link(u, v);
+			merges->merge(u, v, dset.find(u), e.first);
+		}
+		merges->finish([&](index_t i) { return dset.find(i); });
+	}
+
+#ifdef COLLECT_PERSISTENCE_PAIRS
+	persistence_pairs.resize(dim_max + 1);
+#endif
+	for (value_t death : deaths) {
+#ifdef PRINT_PERSISTENCE_PAIRS
+		// ripserq
+		ripserr::out << " [0," << death << ")" << std::endl;
+#endif
+#ifdef COLLECT_PERSISTENCE_PAIRS
+		add_persistence_pair(0, 0.0, death);
+#endif
+	}
+	for (index_t i = 0; i < num_components; ++i) {
+#ifdef PRINT_PERSISTENCE_PAIRS
+		// ripserq
+		ripserr::out << " [0, )" << std::endl;
+#endif
+#ifdef COLLECT_PERSISTENCE_PAIRS
+		add_persistence_pair(0, 0.0, std::numeric_limits<value_t>::infinity());
+#endif
+	}
+#ifdef COLLECT_PERSISTENCE_PAIRS
+	finish_persistence_pairs(0);
+#endif
+	return true;
+}
+
+template <typename DistanceMatrix, typename Index>
+auto ripser<DistanceMatrix, Index>::get_edges(const compressed_lower_distance_matrix& dist)
+    -> std::vector<diameter_index_t> {
+	std::vector<diameter_index_t> edges;
+	std::vector<index_t> vertices(2);
+	for (index_t index = binomial_coeff(n, 2); index-- > 0;) {
+		get_simplex_vertices(index, 1, dist.size(), vertices.rbegin());
+		value_t length = dist(vertices[0], vertices[1]);
+		if (length <= threshold) edges.push_back({length, index});
+	}
+	return edges;
+}
+
+template <typename DistanceMatrix, typename Index>
+auto ripser<DistanceMatrix, Index>::get_edges(const sparse_distance_matrix& dist)
+    -> std::vector<diameter_index_t> {
+	std::vector<diameter_index_t> edges;
+	for (index_t i = 0; i < n; ++i)
+		for (size_t k = dist.offsets[i]; k < dist.offsets[i + 1]; ++k) {
+			index_t j = dist.neighbor_indices[k];
+			if (i > j) edges.push_back({dist.neighbor_diameters[k], get_edge_index(i, j)});
+		}
+	return edges;
+}
+
+// ripserq: R package need not read files.
+#ifdef INPUT_TYPE
+
+enum file_format {
+	LOWER_DISTANCE_MATRIX,
+	UPPER_DISTANCE_MATRIX,
+	DISTANCE_MATRIX,
+	POINT_CLOUD,
+	DIPHA,
+	SPARSE,
+	BINARY
+};
+
+static const uint16_t endian_check(0xff00);
+static const bool is_big_endian = *reinterpret_cast<const uint8_t*>(&endian_check);
+
+template <typename T> T read(std::istream& input_stream) {
+	T result;
+	char* p = reinterpret_cast<char*>(&result);
+	if (input_stream.read(p, sizeof(T)).gcount() != sizeof(T)) return T();
+	if (is_big_endian) std::reverse(p, p + sizeof(T));
+	return result;
+}
+
+inline euclidean_distance_matrix read_point_cloud(std::istream& input_stream) {
+	std::vector<std::vector<value_t>> points;
+
+	std::string line;
+	value_t value;
+	while (std::getline(input_stream, line)) {
+		std::vector<value_t> point;
+		std::istringstream s(line);
+		while (s >> value) {
+			point.push_back(value);
+			s.ignore();
+		}
+		if (!point.empty()) points.push_back(point);
+		assert(point.size() == points.front().size());
+	}
+
+	euclidean_distance_matrix eucl_dist(std::move(points));
+	index_t n = eucl_dist.size();
+	// ripserr: Report on the standard error, since barcodes are written to the
+	// standard output.
+	ripserr::err << "point cloud with " << n << " points in dimension "
+	          << eucl_dist.points.front().size() << std::endl;
+
+	return eucl_dist;
+}
+
+inline sparse_distance_matrix read_sparse_distance_matrix(std::istream& input_stream) {
+	std::vector<std::vector<index_diameter_t>> neighbors;
+	index_t num_edges = 0;
+
+	std::string line;
+	while (std::getline(input_stream, line)) {
+		std::istringstream s(line);
+		size_t i, j;
+		value_t value;
+		s >> i;
+		s.ignore();
+		s >> j;
+		s.ignore();
+		s >> value;
+		s.ignore();
+		if (i != j) {
+			neighbors.resize(std::max({neighbors.size(), i + 1, j + 1}));
+			neighbors[i].push_back({j, value});
+			neighbors[j].push_back({i, value});
+			++num_edges;
+		}
+	}
+
+	for (size_t i = 0; i < neighbors.size(); ++i)
+		std::sort(neighbors[i].begin(), neighbors[i].end());
+
+	return sparse_distance_matrix(std::move(neighbors), num_edges);
+}
+
+inline compressed_lower_distance_matrix read_lower_distance_matrix(std::istream& input_stream) {
+	std::vector<value_t> distances;
+	value_t value;
+	while (input_stream >> value) {
+		distances.push_back(value);
+		input_stream.ignore();
+	}
+
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+inline compressed_lower_distance_matrix read_upper_distance_matrix(std::istream& input_stream) {
+	std::vector<value_t> distances;
+	value_t value;
+	while (input_stream >> value) {
+		distances.push_back(value);
+		input_stream.ignore();
+	}
+
+	return compressed_lower_distance_matrix(compressed_upper_distance_matrix(std::move(distances)));
+}
+
+inline compressed_lower_distance_matrix read_distance_matrix(std::istream& input_stream) {
+	std::vector<value_t> distances;
+
+	std::string line;
+	value_t value;
+	for (int i = 0; std::getline(input_stream, line); ++i) {
+		std::istringstream s(line);
+		for (int j = 0; j < i && s >> value; ++j) {
+			distances.push_back(value);
+			s.ignore();
+		}
+	}
+
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+inline compressed_lower_distance_matrix read_dipha(std::istream& input_stream) {
+	if (read<int64_t>(input_stream) != 8067171840) {
+	  // ripserq
+		ripserr::stop("input is not a Dipha file (magic number: 8067171840)");
+	}
+
+	if (read<int64_t>(input_stream) != 7) {
+	  // ripserq
+		ripserr::stop("input is not a Dipha distance matrix (file type: 7)");
+	}
+
+	index_t n = read<int64_t>(input_stream);
+
+	std::vector<value_t> distances;
+
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < n; ++j)
+			if (i > j)
+				distances.push_back(read<double>(input_stream));
+			else
+				read<double>(input_stream);
+
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+inline compressed_lower_distance_matrix read_binary(std::istream& input_stream) {
+	std::vector<value_t> distances;
+	// ripserr: Stop at the end of the input rather than appending a zero.
+	for (value_t value = read<value_t>(input_stream); input_stream; value = read<value_t>(input_stream))
+		distances.push_back(value);
+	return compressed_lower_distance_matrix(std::move(distances));
+}
+
+inline compressed_lower_distance_matrix read_file(std::istream& input_stream, const file_format format) {
+	switch (format) {
+	case LOWER_DISTANCE_MATRIX:
+		return read_lower_distance_matrix(input_stream);
+	case UPPER_DISTANCE_MATRIX:
+		return read_upper_distance_matrix(input_stream);
+	case DISTANCE_MATRIX:
+		return read_distance_matrix(input_stream);
+	case POINT_CLOUD:
+		return read_point_cloud(input_stream);
+	case DIPHA:
+		return read_dipha(input_stream);
+	default:
+		return read_binary(input_stream);
+	}
+}
+
+// ripserq: R package need not read files.
+#endif
+
+
+typedef std::vector<std::vector<std::pair<value_t, value_t>>> persistence_pairs_t;
+
+template <typename Index, typename DistanceMatrix>
+persistence_pairs_t compute_persistence_pairs(DistanceMatrix dist, index_t dim_max,
+                                              const std::vector<value_t>& thresholds, float ratio,
+                                              coefficient_t modulus, dendrogram* merges, index_t dim_min,
+                                              bool clearing, value_t min_persistence, size_t top_k,
+                                              engine_stats* stats = nullptr, size_t max_memory = 0,
+                                              unsigned num_threads = 1) {
+  ripser<DistanceMatrix, Index> engine(std::move(dist), dim_max, thresholds[0], ratio, modulus);
+  for (size_t d = 1; d < engine.thresholds.size(); ++d) engine.thresholds[d] = thresholds[d];
+  engine.merges = merges;
+  engine.dim_min = dim_min;
+  engine.clearing = clearing;
+  engine.min_persistence = min_persistence;
+  engine.top_k = top_k;
+  engine.stats = stats;
+  engine.max_memory = max_memory;
+  engine.num_threads = num_threads;
+  engine.compute_barcodes();
+  return std::move(engine.persistence_pairs);
+}
+
+// ripserr: The persistence pairs of `dist` in each dimension up to `dim_max`,
+// given one (non-increasing) threshold per dimension. If set, `stats` records
+// the timings and counters of each phase, `max_memory` bounds the memory of the
+// engine in bytes, and large sorts run on up to `num_threads` threads. The
+// distance matrix is dense or sparse.
+template <typename DistanceMatrix>
+persistence_pairs_t ripser_pairs(DistanceMatrix dist, index_t dim_max, const std::vector<value_t>& thresholds,
+                                 float ratio, coefficient_t modulus, dendrogram* merges, index_t dim_min,
+                                 bool clearing, value_t min_persistence, size_t top_k,
+                                 engine_stats* stats = nullptr, size_t max_memory = 0,
+                                 unsigned num_threads = 1) {
+  // use 32-bit simplex indices whenever every simplex up to dimension
+  // `dim_max + 1` (the largest cofacets visited) can be enumerated with them
+  index_t n = dist.size();
+  index_t max_vertices = std::min(dim_max, n - 2) + 2;
+  
+  return index_fits<int32_t>(n, max_vertices)
+             ? compute_persistence_pairs<int32_t>(std::move(dist), dim_max, thresholds, ratio, modulus,
+                                                  merges, dim_min, clearing, min_persistence, top_k, stats,
+                                                  max_memory, num_threads)
+             : compute_persistence_pairs<index_t>(std::move(dist), dim_max, thresholds, ratio, modulus,
+                                                  merges, dim_min, clearing, min_persistence, top_k, stats,
+                                                  max_memory, num_threads);
+}
+
+// ripserr: The estimated size of the computation of one dimension, as reported
+// by `vr_estimate()`.
+struct dimension_estimate {
+	// the simplices within the threshold of the dimension, counted exactly or
+	// (unless `exact`) estimated by sampling
+	double simplices = 0;
+	bool exact = true;
+	// the cofacets enumerated to assemble and reduce the columns, which the time
+	// taken is roughly proportional to
+	double cofacets = 0;
+	// the peak memory of the engine, in bytes, if no column is cleared or lies
+	// in an apparent pair
+	double bytes = 0;
+};
+
+namespace detail {
+
+// The `m`-cliques among `vertices` (in increasing order) in the graph of the
+// distances up to `threshold`, each counted by its largest vertex: over all of
+// them for small sets, and otherwise from one at random (an unbiased estimate,
+// as in Knuth's estimate of the size of a search tree).
+inline double count_cliques(const compressed_lower_distance_matrix& dist, const std::vector<index_t>& vertices,
+                            const int m, const value_t threshold, std::mt19937_64& rng, bool& exact) {
+	if (m == 0) return 1;
+	if (m == 1) return double(vertices.size());
+	const size_t size = vertices.size();
+	const bool all = size <= (m == 2 ? 256 : 16);
+	if (!all) exact = false;
+	double count = 0;
+	std::vector<index_t> lower;
+	for (size_t k = 0; k < (all ? size : 1); ++k) {
+		const size_t i = all ? k : size_t(rng() % size);
+		lower.clear();
+		for (size_t j = 0; j < i; ++j)
+			if (dist(vertices[i], vertices[j]) <= threshold) lower.push_back(vertices[j]);
+		count += count_cliques(dist, lower, m - 1, threshold, rng, exact);
+	}
+	return all ? count : count * size;
+}
+
+} // namespace detail
+
+// ripserr: Estimates the simplices, cofacets and memory of each dimension up to
+// `dim_max` of the computation of `dist`, given one (non-increasing) threshold
+// per dimension. The edges are counted exactly; the simplices of each higher
+// dimension are the cliques on the edges, estimated from the cliques of which
+// `samples` random edges are the largest (or of all edges, if fewer).
+inline std::vector<dimension_estimate> estimate_computation(const compressed_lower_distance_matrix& dist,
+                                                            index_t dim_max,
+                                                            const std::vector<value_t>& thresholds,
+                                                            const size_t samples, const uint64_t seed) {
+	const index_t n = dist.size();
+	dim_max = std::min(dim_max, n - 2);
+	std::vector<dimension_estimate> estimates(dim_max + 1);
+	estimates[0].simplices = n;
+
+	// the edges within the threshold of each dimension
+	std::vector<double> num_edges(dim_max + 1, 0);
+	for (index_t i = 1; i < n; ++i)
+		for (index_t j = 0; j < i; ++j)
+			for (index_t d = 1; d <= dim_max && dist(i, j) <= thresholds[d]; ++d) ++num_edges[d];
+	if (dim_max >= 1) estimates[1].simplices = num_edges[1];
+
+	std::mt19937_64 rng(seed);
+	std::vector<index_t> common;
+	for (index_t d = 2; d <= dim_max; ++d) {
+		dimension_estimate& estimate = estimates[d];
+		const value_t threshold = thresholds[d];
+		if (num_edges[d] == 0) continue;
+		// the ranks of the sampled edges among those within the threshold
+		const bool all = num_edges[d] <= samples;
+		std::vector<double> ranks;
+		if (!all) {
+			for (size_t k = 0; k < samples; ++k) ranks.push_back(double(rng() % uint64_t(num_edges[d])));
+			std::sort(ranks.begin(), ranks.end());
+		}
+		double rank = 0, cliques = 0;
+		size_t next = 0;
+		for (index_t i = 1; i < n && (all || next < ranks.size()); ++i)
+			for (index_t j = 0; j < i; ++j) {
+				if (dist(i, j) > threshold) continue;
+				// the times the edge was drawn
+				size_t draws = all ? 1 : 0;
+				for (; next < ranks.size() && ranks[next] == rank; ++next) ++draws;
+				++rank;
+				if (draws == 0) continue;
+				// the d - 1 other vertices are common neighbors below `j`
+				common.clear();
+				for (index_t w = 0; w < j; ++w)
+					if (dist(i, w) <= threshold && dist(j, w) <= threshold) common.push_back(w);
+				cliques += draws * detail::count_cliques(dist, common, int(d - 1), threshold, rng, estimate.exact);
+			}
+		estimate.simplices = all ? cliques : cliques / samples * num_edges[d];
+		if (!all) estimate.exact = false;
+	}
+
+	// the structures of the engine, as in `ripser::memory()`
+	const double entry = index_fits<int32_t>(n, dim_max + 2) ? sizeof(diameter_index<int32_t>)
+	                                                         : sizeof(diameter_index<index_t>);
+	const double pivot = sizeof(std::pair<const index_t, size_t>) + 3 * sizeof(void*);
+	const double distances = double(n) * (n - 1) / 2 * sizeof(value_t) + double(n) * sizeof(value_t*);
+	auto simplices = [&](index_t d) { return d <= dim_max ? estimates[d].simplices : 0; };
+	// degree 0: the sorted edges and the union-find, or a spanning tree alone
+	estimates[0].cofacets = double(n) * (n - 1) / 2;
+	estimates[0].bytes = distances + (dim_max == 0 ? 2 * n * sizeof(value_t) + n * sizeof(index_t)
+	                                               : 3 * simplices(1) * entry + n * (sizeof(index_t) + 1));
+	for (index_t d = 1; d <= dim_max; ++d) {
+		// every simplex is taken to be a column
+		const double columns = simplices(d);
+		// the simplices kept for the next dimension, or the last ones enumerated
+		const double retained = (d == 1 || d < dim_max) ? simplices(d) : simplices(d - 1);
+		const double reduce = distances + retained * entry + columns * (entry + pivot) +
+		                      columns * (sizeof(size_t) + entry);
+		// the simplices below and above, the columns and their sort, and the
+		// pivots of the dimension below
+		const double assemble = d == 1 ? 0
+		                               : distances + (simplices(d - 1) + (d < dim_max ? simplices(d) : 0)) * entry +
+		                                     3 * columns * entry + simplices(d - 1) * pivot;
+		estimates[d].bytes = std::max(reduce, assemble);
+		estimates[d].cofacets = (d == 1 ? 0 : simplices(d - 1) * (n - d)) + columns * (n - d - 1);
+	}
+	return estimates;
+}
+
+// ripserr: The distance matrix stored in the file at `path`, in the format
+// `"binary"` (the distances below the diagonal as 32-bit floats, row by row, as
+// read by Ripser with `--format binary`) or `"dipha"` (the full matrix of 64-bit
+// floats after the header of a DIPHA distance matrix file). Binary files are
+// read in place; DIPHA files are converted as they are read.
+inline compressed_lower_distance_matrix map_distance_matrix(const std::string& path, const std::string& format) {
+  auto file = std::make_shared<const mapped_file>(path);
+  const size_t size = file->size();
+  
+  if (format == "binary") {
+    const size_t num_distances = size / sizeof(value_t);
+    const size_t n = (1 + std::sqrt(1 + 8 * double(num_distances))) / 2;
+    if (size % sizeof(value_t) != 0 || n * (n - 1) / 2 != num_distances || n < 2)
+      ripserr::stop("file '%s' does not hold a lower-triangular distance matrix of 32-bit floats", path);
+    return compressed_lower_distance_matrix(std::move(file), 0, num_distances);
+  }
+  
+  int64_t header[3] = {0, 0, 0};
+  if (size >= sizeof(header)) std::memcpy(header, file->data(), sizeof(header));
+  if (header[0] != 8067171840)
+    ripserr::stop("file '%s' is not a DIPHA file (magic number: 8067171840)", path);
+  if (header[1] != 7)
+    ripserr::stop("file '%s' is not a DIPHA distance matrix (file type: 7)", path);
+  const size_t n = size_t(header[2]);
+  if (header[2] < 2 || size != sizeof(header) + n * n * sizeof(double))
+    ripserr::stop("file '%s' does not hold the full distance matrix of %d points", path, int(header[2]));
+  
+  std::vector<value_t> distances;
+  distances.reserve(n * (n - 1) / 2);
+  const char* row = file->data() + sizeof(header);
+  for (size_t i = 0; i < n; ++i, row += n * sizeof(double))
+    for (size_t j = 0; j < i; ++j) {
+      double value;
+      std::memcpy(&value, row + j * sizeof(double), sizeof(double));
+      distances.push_back(value_t(value));
+    }
+  return compressed_lower_distance_matrix(std::move(distances));
+}
+
+} // namespace vr
+
+#endif
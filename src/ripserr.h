@@ -0,0 +1,253 @@
+// ripserr: the persistence engines as a header-only C++ library.
+//
+// The engines do not depend on R: compiled with `RIPSERR_STANDALONE` defined,
+// they report through the standard streams, and this interface takes views of
+// the input (which is read in place), fills a barcode, and returns a status
+// rather than throwing. The R package calls the engines through the thin
+// adapters in the .cpp files instead, so that errors become R conditions.
+
+#ifndef RIPSERR_RIPSERR_H
+#define RIPSERR_RIPSERR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <string>
+#include <vector>
+#include "ripser.h"
+#include "cubical_2dim.h"
+#include "cubical_3dim.h"
+#include "cubical_4dim.h"
+#include "emst.h"
+#include "phom.h"
+#include "sliding_window.h"
+
+namespace ripserr {
+
+// A read-only view of `size` contiguous values.
+template <typename T> struct span {
+	const T* data;
+	size_t size;
+
+	span(const T* _data, size_t _size) : data(_data), size(_size) {}
+	span(const std::vector<T>& values) : data(values.data()), size(values.size()) {}
+
+	const T& operator[](size_t i) const { return data[i]; }
+};
+
+// The pairs of a barcode, as the columns of a `PHom` object.
+struct barcode {
+	std::vector<int> dimension;
+	std::vector<double> birth, death;
+
+	size_t size() const { return dimension.size(); }
+
+	void clear() {
+		dimension.clear();
+		birth.clear();
+		death.clear();
+	}
+
+	void push_back(int dim, double b, double d) {
+		dimension.push_back(dim);
+		birth.push_back(b);
+		death.push_back(d);
+	}
+};
+
+enum status {
+	OK = 0,
+	// the input or options are invalid (see the message)
+	INVALID_ARGUMENT,
+	// the engine failed, typically for lack of memory (see the message)
+	ENGINE_ERROR
+};
+
+// The options of `vietoris_rips()`, with its defaults.
+struct vr_options {
+	int max_dim = 1;
+	// no threshold if infinite
+	double threshold = std::numeric_limits<double>::infinity();
+	float ratio = 1;
+	int p = 2;
+	// pairs of lower dimensions are not reported
+	int min_dim = 0;
+	bool clearing = true;
+	double min_persistence = 0;
+	// all pairs if 0
+	size_t top_k = 0;
+	// the bytes the engine may hold before it fails, or no bound if 0
+	size_t max_memory = 0;
+	// the threads on which the parallel parts of the engine may run
+	unsigned threads = 1;
+};
+
+// The options of `cubical()`, with its defaults.
+struct cubical_options {
+	double threshold = 9999;
+	// 0 for the link-join algorithm ("lj"), 1 for compute pairs ("cp")
+	int method = 0;
+	bool sublevel = true;
+	// all pairs if 0
+	size_t top_k = 0;
+	// the threads on which large lists of cells are sorted
+	unsigned threads = 1;
+};
+
+namespace detail {
+
+inline status fail(status code, const char* what, std::string* message) {
+	if (message) *message = what;
+	return code;
+}
+
+template <typename WritePairs>
+void append_cubical_pairs(std::vector<WritePairs>& pairs, double min_value, const cubical_options& options,
+                          barcode& result) {
+	const size_t skip = whole_image_pair(pairs, min_value, options.threshold);
+	const double sign = options.sublevel ? 1 : -1;
+	for (size_t i = 0; i < pairs.size(); ++i)
+		if (i != skip)
+			result.push_back(int(pairs[i].getDimension()), sign * pairs[i].getBirth(),
+			                 sign * pairs[i].getDeath());
+}
+
+} // namespace detail
+
+// Calculates the Vietoris-Rips persistence of the distance matrix given by its
+// `n * (n - 1) / 2` entries below the diagonal, row by row (`d(1, 0)`,
+// `d(2, 0)`, `d(2, 1)`, ...), as does `vietoris_rips()`. The distances are read
+// in place. The pairs are appended to `result` in order of dimension.
+inline status vietoris_rips(span<float> distances, const vr_options& options, barcode& result,
+                            std::string* message = nullptr) noexcept {
+	const size_t n = (1 + std::sqrt(1 + 8 * double(distances.size))) / 2;
+	if (n < 2 || n * (n - 1) / 2 != distances.size)
+		return detail::fail(INVALID_ARGUMENT, "the distances do not form a lower-triangular matrix",
+		                    message);
+	if (options.max_dim < 0 || options.min_dim < 0 || options.p < 2)
+		return detail::fail(INVALID_ARGUMENT, "invalid dimensions or coefficients", message);
+	try {
+		vr::compressed_lower_distance_matrix dist(distances.data, distances.size);
+		vr::persistence_pairs_t pairs = vr::ripser_pairs(
+		    std::move(dist), options.max_dim,
+		    std::vector<vr::value_t>(options.max_dim + 1, vr::value_t(options.threshold)), options.ratio,
+		    vr::coefficient_t(options.p), nullptr, options.min_dim, options.clearing,
+		    vr::value_t(options.min_persistence), options.top_k, nullptr, options.max_memory, options.threads);
+		for (size_t d = 0; d < pairs.size(); ++d)
+			for (const auto& pair : pairs[d]) result.push_back(int(d), pair.first, pair.second);
+	} catch (const std::exception& e) {
+		return detail::fail(ENGINE_ERROR, e.what(), message);
+	}
+	return OK;
+}
+
+// Calculates the degree-0 Vietoris-Rips persistence of the `n` points of
+// dimension `d`, stored as the columns of a column-major array with one point
+// per row (as in an R matrix), without forming their distance matrix.
+inline status vietoris_rips_0(span<double> points, size_t d, const vr_options& options, barcode& result,
+                              std::string* message = nullptr) noexcept {
+	if (d == 0 || points.size % d != 0 || points.size / d < 1)
+		return detail::fail(INVALID_ARGUMENT, "the points do not form an array of `d` columns", message);
+	try {
+		std::vector<emst::value_t> deaths =
+		    emst::dim_0_deaths(points.data, emst::index_t(points.size / d), emst::index_t(d),
+		                       options.threshold, options.min_persistence, int(options.top_k), nullptr,
+		                       nullptr, options.threads);
+		for (emst::value_t death : deaths) result.push_back(0, 0, death);
+	} catch (const std::exception& e) {
+		return detail::fail(ENGINE_ERROR, e.what(), message);
+	}
+	return OK;
+}
+
+// Calculates the Vietoris-Rips persistence of each window of `window`
+// consecutive points, starting every `step` points, of the `n` points of
+// dimension `d` stored as for `vietoris_rips_0()`. The windows are calculated
+// on `options.threads` threads, each window on one of them. The distances of
+// each point to those of the windows it shares are computed once. One barcode
+// per window is appended to `results`.
+inline status vietoris_rips_windows(span<double> points, size_t d, size_t window, size_t step,
+                                    const vr_options& options, std::vector<barcode>& results,
+                                    std::string* message = nullptr) noexcept {
+	if (d == 0 || points.size % d != 0)
+		return detail::fail(INVALID_ARGUMENT, "the points do not form an array of `d` columns", message);
+	if (window < 2 || step < 1)
+		return detail::fail(INVALID_ARGUMENT, "the windows need at least 2 points and a positive step", message);
+	if (options.max_dim < 0 || options.min_dim < 0 || options.p < 2)
+		return detail::fail(INVALID_ARGUMENT, "invalid dimensions or coefficients", message);
+	try {
+		const vr::euclidean_points stream(points.data, vr::index_t(points.size / d), vr::index_t(d));
+		const std::vector<vr::value_t> thresholds(options.max_dim + 1, vr::value_t(options.threshold));
+		std::vector<vr::persistence_pairs_t> pairs = vr::sliding_window_pairs(
+		    stream.size(), vr::index_t(window), vr::index_t(step), stream,
+		    [&](vr::compressed_lower_distance_matrix&& dist) {
+			    return vr::ripser_pairs(std::move(dist), options.max_dim, thresholds, options.ratio,
+			                            vr::coefficient_t(options.p), nullptr, options.min_dim, options.clearing,
+			                            vr::value_t(options.min_persistence), options.top_k, nullptr,
+			                            options.max_memory);
+		    },
+		    std::max(1u, options.threads));
+		for (const auto& window_pairs : pairs) {
+			barcode result;
+			for (size_t dim = 0; dim < window_pairs.size(); ++dim)
+				for (const auto& pair : window_pairs[dim]) result.push_back(int(dim), pair.first, pair.second);
+			results.push_back(std::move(result));
+		}
+	} catch (const std::exception& e) {
+		return detail::fail(ENGINE_ERROR, e.what(), message);
+	}
+	return OK;
+}
+
+// Calculates the cubical persistence of the image with the given extents (1 to
+// 4 of them, with the first index varying fastest, as in an R array), as does
+// `cubical()`. The values are read in place. The feature of the whole image is
+// not reported.
+inline status cubical(span<double> values, span<int> extents, const cubical_options& options,
+                      barcode& result, std::string* message = nullptr) noexcept {
+	size_t num_values = 1;
+	for (size_t d = 0; d < extents.size; ++d) num_values *= size_t(std::max(extents[d], 0));
+	if (extents.size < 1 || extents.size > 4 || num_values == 0 || num_values != values.size)
+		return detail::fail(INVALID_ARGUMENT, "the values do not form an image of the given extents",
+		                    message);
+	// the sizes of the engines' grids
+	const int limits[4][4] = {{2000, 1, 1, 1}, {2000, 1000, 1, 1}, {512, 512, 512, 1}, {64, 64, 64, 64}};
+	int n[4] = {1, 1, 1, 1};
+	for (size_t d = 0; d < extents.size; ++d) {
+		n[d] = extents[d];
+		if (n[d] >= limits[extents.size - 1][d])
+			return detail::fail(INVALID_ARGUMENT, "the image is too large for the engine", message);
+	}
+	if (options.method != 0 && options.method != 1)
+		return detail::fail(INVALID_ARGUMENT, "the method must be 0 (link join) or 1 (compute pairs)", message);
+	try {
+		const voxel_buffer voxels(values.data, !options.sublevel);
+		const int top_k = int(options.top_k);
+		double min_value;
+		if (extents.size <= 2) {
+			std::vector<cubical2::WritePairs2> pairs = cubical2::cubical_2dim_pairs(
+			    voxels, options.threshold, options.method, n[0], n[1], top_k, nullptr, min_value,
+			    nullptr, options.threads);
+			detail::append_cubical_pairs(pairs, min_value, options, result);
+		} else if (extents.size == 3) {
+			std::vector<cubical3::WritePairs3> pairs = cubical3::cubical_3dim_pairs(
+			    voxels, options.threshold, options.method, n[0], n[1], n[2], top_k, nullptr, min_value,
+			    nullptr, options.threads);
+			detail::append_cubical_pairs(pairs, min_value, options, result);
+		} else {
+			std::vector<cubical4::WritePairs4> pairs = cubical4::cubical_4dim_pairs(
+			    voxels, options.threshold, options.method, n[0], n[1], n[2], n[3], top_k, nullptr, min_value,
+			    nullptr, options.threads);
+			detail::append_cubical_pairs(pairs, min_value, options, result);
+		}
+	} catch (const std::exception& e) {
+		return detail::fail(ENGINE_ERROR, e.what(), message);
+	}
+	return OK;
+}
+
+} // namespace ripserr
+
+#endif
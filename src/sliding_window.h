@@ -0,0 +1,156 @@
+// ripserr: Vietoris-Rips persistence of the sliding windows of a stream of
+// points.
+//
+// Consecutive windows share all but `step` of their points, so the distances
+// among the last `window` points of the stream are kept in a ring buffer: each
+// point entering it has its distances to the others computed once, replacing
+// those of the oldest point, and each window copies its distance matrix out of
+// the buffer in order. The windows are taken in turn by a pool of threads,
+// each of which fills the buffer up to its window under a lock and then runs
+// Ripser on its copy, so that at most one window per thread is held at once.
+
+#ifndef RIPSERR_SLIDING_WINDOW_H
+#define RIPSERR_SLIDING_WINDOW_H
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "ripser.h"
+
+namespace vr {
+
+// The distances among the last `capacity` points of a stream.
+class distance_ring {
+	index_t capacity;
+	// the points so far
+	index_t count = 0;
+	// the distances of each point held to the points before it, in the row of
+	// its slot and the columns of theirs
+	std::vector<value_t> rows;
+
+	index_t slot(index_t p) const { return p % capacity; }
+
+public:
+	explicit distance_ring(index_t _capacity) : capacity(_capacity), rows(size_t(_capacity) * _capacity) {}
+
+	// the points so far, including those dropped
+	index_t size() const { return count; }
+
+	// Continues the stream at point `p`, if it is further; the points skipped
+	// are never held.
+	void skip_to(index_t p) { count = std::max(count, p); }
+
+	// Appends the next point `p`, given its distance to each earlier point `q`
+	// held from `first_held` on as `distance(p, q)`, dropping the oldest point
+	// if the ring is full.
+	template <typename Distance> void push(const Distance& distance, index_t first_held) {
+		value_t* row = &rows[size_t(slot(count)) * capacity];
+		for (index_t q = std::max(first_held, count - capacity + 1); q < count; ++q)
+			row[slot(q)] = distance(count, q);
+		++count;
+	}
+
+	// The distance matrix of the `size` consecutive points from point `first`,
+	// which must all be held.
+	compressed_lower_distance_matrix window(index_t first, index_t size) const {
+		assert(first + size <= count && count - first <= capacity);
+		std::vector<value_t> distances(size_t(size) * (size - 1) / 2);
+		value_t* out = distances.data();
+		for (index_t i = 1; i < size; ++i) {
+			const value_t* row = &rows[size_t(slot(first + i)) * capacity];
+			for (index_t j = 0, s = slot(first); j < i; ++j, s = s + 1 == capacity ? 0 : s + 1) *out++ = row[s];
+		}
+		return compressed_lower_distance_matrix(std::move(distances));
+	}
+};
+
+// The Euclidean distances between the `n` points of dimension `d` stored as
+// the columns of a column-major array (as in an R matrix), computed in double
+// precision as by `stats::dist()`.
+class euclidean_points {
+	index_t d;
+	std::vector<double> points;
+
+public:
+	euclidean_points(const double* columns, index_t n, index_t _d) : d(_d), points(size_t(n) * _d) {
+		for (index_t p = 0; p < n; ++p)
+			for (index_t c = 0; c < d; ++c) points[size_t(p) * d + c] = columns[size_t(c) * n + p];
+	}
+
+	index_t size() const { return index_t(points.size() / d); }
+
+	value_t operator()(index_t p, index_t q) const {
+		const double* u = &points[size_t(p) * d];
+		const double* v = &points[size_t(q) * d];
+		double sum = 0;
+		for (index_t c = 0; c < d; ++c) sum += (u[c] - v[c]) * (u[c] - v[c]);
+		return value_t(std::sqrt(sum));
+	}
+};
+
+// The number of windows of `window` consecutive points of a stream of
+// `num_points`, starting every `step` points.
+inline index_t num_windows(index_t num_points, index_t window, index_t step) {
+	return num_points < window ? 0 : (num_points - window) / step + 1;
+}
+
+// The result of `pairs(dist)` for the distance matrix `dist` of each window of
+// `window` consecutive points, starting every `step` points, of the stream of
+// the `num_points` points between which `distance(p, q)` are the distances,
+// computed on `num_threads` threads (or as many as the hardware runs if 0).
+// The first exception thrown, on any thread, is rethrown once all have
+// stopped; the other threads then take no further windows.
+template <typename Distance, typename Pairs>
+auto sliding_window_pairs(index_t num_points, index_t window, index_t step, const Distance& distance,
+                          const Pairs& pairs, unsigned num_threads)
+    -> std::vector<decltype(pairs(std::declval<compressed_lower_distance_matrix>()))> {
+	RIPSERR_TRACE_ZONE("sliding_window_pairs");
+	const index_t windows = num_windows(num_points, window, step);
+	std::vector<decltype(pairs(std::declval<compressed_lower_distance_matrix>()))> result(windows);
+
+	distance_ring ring(window);
+	std::mutex ring_mutex;
+	index_t next_window = 0;
+	std::atomic<bool> abandoned(false);
+	std::exception_ptr error;
+
+	auto work = [&](unsigned t) {
+		// only the calling thread may call R
+		ripserr::worker_thread() = t > 0;
+		try {
+			while (!abandoned) {
+				index_t w;
+				compressed_lower_distance_matrix dist(std::vector<value_t>{});
+				{
+					std::lock_guard<std::mutex> lock(ring_mutex);
+					if (next_window == windows) break;
+					w = next_window++;
+					const index_t first = w * step;
+					ring.skip_to(first);
+					while (ring.size() < first + window) ring.push(distance, first);
+					dist = ring.window(first, window);
+				}
+				result[w] = pairs(std::move(dist));
+				if (t == 0) ripserr::check_interrupt();
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(ring_mutex);
+			if (!error) error = std::current_exception();
+			abandoned = true;
+		}
+	};
+
+	if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+	num_threads = unsigned(std::max<index_t>(1, std::min<index_t>(num_threads, windows)));
+	std::vector<std::thread> threads;
+	for (unsigned t = 1; t < num_threads; ++t) threads.emplace_back(work, t);
+	work(0);
+	for (auto& thread : threads) thread.join();
+	if (error) std::rethrow_exception(error);
+	return result;
+}
+
+} // namespace vr
+
+#endif
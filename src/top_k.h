@@ -0,0 +1,65 @@
+// ripserr: bounded selection of the most persistent pairs.
+//
+// When only the k most persistent pairs of each dimension are wanted, the pairs
+// found so far are kept in a min-heap by persistence of at most k elements, so
+// that memory does not grow with the number of (mostly near-diagonal) pairs.
+
+#ifndef RIPSERR_TOP_K_H
+#define RIPSERR_TOP_K_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// The most persistent pairs found so far, each with the number of pairs pushed
+// before it, which breaks ties between equally persistent pairs.
+template <class Pair> struct most_persistent {
+	std::vector<std::pair<Pair, size_t>> heap;
+	size_t pushed = 0;
+};
+
+// Whether `a` comes before `b` in order of decreasing persistence, the earlier
+// of two equally persistent pairs first.
+template <class Pair, class Persistence>
+bool more_persistent(const std::pair<Pair, size_t>& a, const std::pair<Pair, size_t>& b,
+                     Persistence persistence) {
+	const auto persistence_a = persistence(a.first), persistence_b = persistence(b.first);
+	return persistence_a > persistence_b || (persistence_a == persistence_b && a.second < b.second);
+}
+
+// Adds `pair` to the heap `top` of at most `k` pairs, evicting the least
+// persistent pair if it is full. Of equally persistent pairs, the earlier ones
+// are kept.
+template <class Pair, class Persistence>
+void push_most_persistent(most_persistent<Pair>& top, const Pair& pair, const size_t k,
+                          Persistence persistence) {
+	auto comp = [&](const std::pair<Pair, size_t>& a, const std::pair<Pair, size_t>& b) {
+		return more_persistent(a, b, persistence);
+	};
+	std::pair<Pair, size_t> entry(pair, top.pushed++);
+	if (top.heap.size() < k) {
+		top.heap.push_back(entry);
+		std::push_heap(top.heap.begin(), top.heap.end(), comp);
+	} else if (k > 0 && comp(entry, top.heap.front())) {
+		std::pop_heap(top.heap.begin(), top.heap.end(), comp);
+		top.heap.back() = entry;
+		std::push_heap(top.heap.begin(), top.heap.end(), comp);
+	}
+}
+
+// Appends the pairs of the heap `top` to `pairs` in order of decreasing
+// persistence, the earlier of two equally persistent pairs first, and empties
+// the heap.
+template <class Pair, class Persistence>
+void append_most_persistent(most_persistent<Pair>& top, std::vector<Pair>& pairs, Persistence persistence) {
+	std::sort_heap(top.heap.begin(), top.heap.end(),
+	               [&](const std::pair<Pair, size_t>& a, const std::pair<Pair, size_t>& b) {
+		               return more_persistent(a, b, persistence);
+	               });
+	for (const auto& entry : top.heap) pairs.push_back(entry.first);
+	top.heap.clear();
+	top.pushed = 0;
+}
+
+#endif
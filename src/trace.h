@@ -0,0 +1,165 @@
+// ripserr: timelines of the engines as Chrome trace files.
+//
+// Compiled with `RIPSERR_TRACE` defined (for instance through `PKG_CPPFLAGS` in
+// ~/.R/Makevars, or `make TRACE=1` in cli/), the engines record a zone for each
+// of their phases and for batches of columns, and an instant event wherever
+// they check for interrupts. Whenever the outermost zone ends, the events so
+// far are appended to the file named by the environment variable
+// `RIPSERR_TRACE_FILE` (by default ripserr-trace.json in the working
+// directory), which is truncated by the first call of the process. The file is
+// in the JSON array format of the Trace Event Format, which may lack its
+// closing bracket, and opens in chrome://tracing and https://ui.perfetto.dev.
+//
+// Without `RIPSERR_TRACE`, the macros below expand to nothing.
+
+#ifndef RIPSERR_TRACE_H
+#define RIPSERR_TRACE_H
+
+#ifdef RIPSERR_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ripserr {
+namespace trace {
+
+struct event {
+	const char* name;
+	// 'X' for a zone (complete event), 'i' for an instant event
+	char type;
+	double start, duration;
+	// the dimension and the first column of a batch, or -1
+	long long dim, first;
+	size_t thread;
+};
+
+class recorder {
+	std::mutex mutex;
+	std::vector<event> events;
+	const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+	int depth = 0;
+	bool started = false;
+
+	void flush() {
+		const char* path = std::getenv("RIPSERR_TRACE_FILE");
+		if (!path || !*path) path = "ripserr-trace.json";
+		std::FILE* file = std::fopen(path, started ? "a" : "w");
+		if (!file) return;
+		if (!started) std::fputs("[\n", file);
+		started = true;
+		for (const event& e : events) {
+			std::fprintf(file, "{\"name\":\"%s\",\"cat\":\"ripserr\",\"ph\":\"%c\",\"ts\":%.3f,", e.name, e.type,
+			             e.start);
+			if (e.type == 'X')
+				std::fprintf(file, "\"dur\":%.3f,", e.duration);
+			else
+				std::fputs("\"s\":\"t\",", file);
+			std::fprintf(file, "\"pid\":1,\"tid\":%zu,\"args\":{", e.thread);
+			if (e.dim >= 0) std::fprintf(file, "\"dim\":%lld%s", e.dim, e.first >= 0 ? "," : "");
+			if (e.first >= 0) std::fprintf(file, "\"first\":%lld", e.first);
+			std::fputs("}},\n", file);
+		}
+		std::fclose(file);
+		events.clear();
+	}
+
+public:
+	// microseconds since the recorder was created
+	double now() const {
+		return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin).count();
+	}
+
+	void begin() {
+		std::lock_guard<std::mutex> lock(mutex);
+		++depth;
+	}
+
+	void end(const event& e) {
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(e);
+		if (--depth == 0) flush();
+	}
+
+	void instant(const char* name) {
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back({name, 'i', now(), 0, -1, -1, thread_id()});
+		if (depth == 0) flush();
+	}
+
+	static size_t thread_id() { return std::hash<std::thread::id>()(std::this_thread::get_id()) % 100000; }
+};
+
+// The recorder of the process, which is never destroyed (so that no trace is
+// lost to the order of destruction at exit).
+inline recorder& events() {
+	static recorder* r = new recorder();
+	return *r;
+}
+
+class zone {
+	event e;
+
+public:
+	zone(const char* name, long long dim = -1, long long first = -1)
+	    : e{name, 'X', 0, 0, dim, first, recorder::thread_id()} {
+		events().begin();
+		e.start = events().now();
+	}
+
+	~zone() {
+		e.duration = events().now() - e.start;
+		events().end(e);
+	}
+
+	zone(const zone&) = delete;
+	zone& operator=(const zone&) = delete;
+};
+
+// Zones of consecutive batches of `size` columns; `next(i)` before column `i`
+// ends the current batch and begins the next one when `i` is a multiple of
+// `size`.
+class batches {
+	const char* name;
+	long long dim, size;
+	zone* current = nullptr;
+
+public:
+	batches(const char* _name, long long _dim, long long _size) : name(_name), dim(_dim), size(_size) {}
+	~batches() { delete current; }
+
+	void next(long long i) {
+		if (i % size != 0) return;
+		delete current;
+		current = new zone(name, dim, i);
+	}
+};
+
+} // namespace trace
+} // namespace ripserr
+
+#define RIPSERR_TRACE_CONCAT_(a, b) a##b
+#define RIPSERR_TRACE_CONCAT(a, b) RIPSERR_TRACE_CONCAT_(a, b)
+// A zone from here to the end of the enclosing scope, optionally of a dimension.
+#define RIPSERR_TRACE_ZONE(...)                                                                            \
+	ripserr::trace::zone RIPSERR_TRACE_CONCAT(ripserr_trace_zone_, __LINE__)(__VA_ARGS__)
+// Zones `name` of each `size` columns of dimension `dim`, to be advanced by
+// `RIPSERR_TRACE_NEXT_BATCH(var, i)`.
+#define RIPSERR_TRACE_BATCHES(var, name, dim, size) ripserr::trace::batches var(name, dim, size)
+#define RIPSERR_TRACE_NEXT_BATCH(var, i) var.next(i)
+#define RIPSERR_TRACE_INSTANT(name) ripserr::trace::events().instant(name)
+
+#else
+
+#define RIPSERR_TRACE_ZONE(...)
+#define RIPSERR_TRACE_BATCHES(var, name, dim, size)
+#define RIPSERR_TRACE_NEXT_BATCH(var, i)
+#define RIPSERR_TRACE_INSTANT(name)
+
+#endif
+
+#endif
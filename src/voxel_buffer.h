@@ -0,0 +1,77 @@
+// ripserr: read-only views of voxel values in memory or in mapped files.
+//
+// The cubical engines read the value of each voxel from its buffer as needed,
+// so that neither R arrays nor (memory-mapped) image files are copied into a
+// separate grid of doubles.
+
+#ifndef RIPSERR_VOXEL_BUFFER_H
+#define RIPSERR_VOXEL_BUFFER_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include "console.h"
+#include "mapped_file.h"
+
+enum voxel_type { VOXEL_FLOAT64, VOXEL_FLOAT32, VOXEL_UINT16 };
+
+inline size_t voxel_size(const voxel_type type) {
+	switch (type) {
+	case VOXEL_FLOAT32:
+		return 4;
+	case VOXEL_UINT16:
+		return 2;
+	default:
+		return 8;
+	}
+}
+
+// Returns the type named by `dtype`, as in the `type` argument of `cubical_file()`.
+inline voxel_type voxel_type_of(const std::string& dtype) {
+	if (dtype == "float64") return VOXEL_FLOAT64;
+	if (dtype == "float32") return VOXEL_FLOAT32;
+	if (dtype == "uint16") return VOXEL_UINT16;
+	ripserr::stop("unsupported voxel type '%s'", dtype);
+}
+
+class voxel_buffer {
+	const char* data;
+	voxel_type type;
+	// -1 to read the negated values (for superlevel set filtrations)
+	double sign;
+	// keeps the mapped file, if any, open as long as the buffer is used
+	std::shared_ptr<const mapped_file> file;
+
+public:
+	// The values of an array of doubles (such as an R vector), which must outlive
+	// the buffer.
+	explicit voxel_buffer(const double* values, bool negate = false)
+	    : data(reinterpret_cast<const char*>(values)), type(VOXEL_FLOAT64), sign(negate ? -1 : 1) {}
+
+	// The values of type `type` in native byte order from byte `offset` of `file`.
+	voxel_buffer(std::shared_ptr<const mapped_file> _file, size_t offset, voxel_type _type, bool negate)
+	    : data(_file->data() + offset), type(_type), sign(negate ? -1 : 1), file(std::move(_file)) {}
+
+	double operator[](const size_t i) const {
+		switch (type) {
+		case VOXEL_FLOAT32: {
+			float value;
+			std::memcpy(&value, data + i * sizeof(float), sizeof(float));
+			return sign * value;
+		}
+		case VOXEL_UINT16: {
+			uint16_t value;
+			std::memcpy(&value, data + i * sizeof(uint16_t), sizeof(uint16_t));
+			return sign * value;
+		}
+		default: {
+			double value;
+			std::memcpy(&value, data + i * sizeof(double), sizeof(double));
+			return sign * value;
+		}
+		}
+	}
+};
+
+#endif